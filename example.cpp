@@ -14,11 +14,17 @@ int main() {
   wav.addSineWave(200, 1, 500);
   wav.addSineWave(100, 1, 1000);
 
-  // Random Sequence of Sine Waves
+  // Pseudo-random Sequence of Sine Waves
   for (int i = 0; i < 20; i++) {
-    wav.addSineWave(rand() % 4000, 1, 100);
+    wav.addSineWave(100 + (i * 1237) % 3900, 1, 100);
   }
 
+  // Seeded noise, the same every run
+  wav.setNoiseSeed(2023);
+  wav.addWhiteNoise(0.5, wavgen::SAMPLE_RATE / 2);
+  wav.addPinkNoise(0.5, wavgen::SAMPLE_RATE / 2);
+  wav.addBandLimitedNoise(1000, 2000, 0.2, wavgen::SAMPLE_RATE / 2);
+
   // Triangle wave
   int16_t sample = 0.0;
   int16_t delta = 50;
@@ -0,0 +1,113 @@
+/**
+ * @file wav_batch.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Render many WAV files concurrently from a job manifest.
+ * @date 2023-09-09
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef WAV_BATCH_HPP_
+#define WAV_BATCH_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace wavgen {
+
+/**
+ * @brief A single segment of a batch job.
+ */
+struct BatchSegment {
+  enum class Type {
+    SINE_WAVE,   // Generator::addSineWave()
+    SILENCE,     // Generator::addSilence()
+    WHITE_NOISE, // Generator::addWhiteNoise()
+    PINK_NOISE   // Generator::addPinkNoise()
+  };
+
+  Type type = Type::SILENCE;
+  uint16_t frequency = 0;
+  double amplitude = 0.0;
+  uint16_t duration_ms = 0;
+};
+
+/**
+ * @brief A file to render.
+ */
+struct BatchJob {
+  std::string output_path{};
+  uint64_t noise_seed = 0;
+  std::vector<BatchSegment> segments{};
+};
+
+/**
+ * @brief Parse a job manifest.
+ *
+ * One job per line, blank lines and lines starting with # are ignored:
+ * @code
+ * <output_path> [seed=<n>] <segment> <segment> ...
+ * @endcode
+ * Where each segment is one of:
+ * @code
+ * sine:<frequency_hz>:<amplitude>:<duration_ms>
+ * silence:<duration_ms>
+ * white:<amplitude>:<duration_ms>
+ * pink:<amplitude>:<duration_ms>
+ * @endcode
+ *
+ * @param manifest - The manifest to parse.
+ * @return std::vector<BatchJob> - The jobs.
+ * @throws std::runtime_error - If a line is malformed.
+ */
+std::vector<BatchJob> parseBatchManifest(std::istream &manifest);
+
+/**
+ * @brief Batch rendering options.
+ */
+struct BatchOptions {
+  /**
+   * @brief The number of worker threads, 0 to use one per hardware thread.
+   */
+  uint32_t num_threads = 0;
+
+  /**
+   * @brief The size of each worker's tone cache in bytes, 0 to disable it.
+   * Workers keep their cache across jobs, so segments shared between files
+   * are only synthesized once per worker.
+   */
+  size_t tone_cache_bytes = 0;
+};
+
+/**
+ * @brief The result of a batch render.
+ */
+struct BatchResult {
+  uint32_t jobs_completed = 0;
+  uint32_t jobs_failed = 0;
+
+  /**
+   * @brief A message for each failed job, prefixed with its output path.
+   */
+  std::vector<std::string> errors{};
+};
+
+/**
+ * @brief Render a list of jobs on a work-stealing thread pool.
+ *
+ * Each worker owns one Generator that is reopened for every job, so the
+ * sample buffers, tone cache and file stream are reused instead of being
+ * set up per file. A failing job is recorded in the result and does not
+ * stop the others.
+ *
+ * @param jobs - The jobs to render.
+ * @param options - The rendering options.
+ * @return BatchResult - The number of completed and failed jobs.
+ */
+BatchResult renderBatch(const std::vector<BatchJob> &jobs,
+                        const BatchOptions &options = BatchOptions());
+
+} // namespace wavgen
+
+#endif /* WAV_BATCH_HPP_ */
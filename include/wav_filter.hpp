@@ -0,0 +1,233 @@
+/**
+ * @file wav_filter.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Block based IIR and FIR filters for generated and read audio.
+ * @date 2023-08-05
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef WAV_FILTER_HPP_
+#define WAV_FILTER_HPP_
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace wavgen {
+
+class Fft;
+
+/**
+ * @brief The base class for filters. Filters operate in place on blocks of
+ * samples and keep their state between calls, so a long signal can be
+ * processed one block at a time.
+ *
+ * A filter can be attached to a Writer (applied to each block right before
+ * it is written) or a Reader (applied to each block right after it is read).
+ */
+class Filter {
+public:
+  Filter() = default;
+  virtual ~Filter() = default;
+
+  /**
+   * @brief Filter a block of samples in place.
+   * @param samples - The samples to filter, nominally in the range [-1, 1].
+   * @param num_samples - The number of samples in the block.
+   */
+  virtual void process(float *samples, size_t num_samples) = 0;
+
+  /**
+   * @brief Filter a block of 16-bit samples in place. The samples are
+   * converted to float in small chunks, filtered, and converted back with
+   * saturation.
+   * @param samples - The samples to filter.
+   * @param num_samples - The number of samples in the block.
+   */
+  void process(int16_t *samples, size_t num_samples);
+
+  /**
+   * @brief Clear the filter state (delay lines), keeping the coefficients.
+   */
+  virtual void reset() = 0;
+};
+
+/**
+ * @brief A cascade of second order IIR sections (biquads) in transposed
+ * direct form II.
+ */
+class BiquadFilter : public Filter {
+public:
+  /**
+   * @brief The normalized coefficients of a single section (a0 = 1).
+   */
+  struct Coefficients {
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+  };
+
+  /**
+   * @brief The Q of a second order Butterworth section.
+   */
+  static constexpr double kButterworthQ = 0.7071067811865476;
+
+  /**
+   * @brief Low pass section (RBJ cookbook).
+   * @param cutoff_hz - The cutoff frequency in Hz.
+   * @param q - The quality factor of the section.
+   * @return Coefficients - The section coefficients.
+   */
+  static Coefficients lowPass(double cutoff_hz, double q = kButterworthQ);
+
+  /**
+   * @brief High pass section (RBJ cookbook).
+   * @param cutoff_hz - The cutoff frequency in Hz.
+   * @param q - The quality factor of the section.
+   * @return Coefficients - The section coefficients.
+   */
+  static Coefficients highPass(double cutoff_hz, double q = kButterworthQ);
+
+  /**
+   * @brief Band pass section with a constant 0 dB peak gain (RBJ cookbook).
+   * @param center_hz - The center frequency in Hz.
+   * @param q - The quality factor of the section.
+   * @return Coefficients - The section coefficients.
+   */
+  static Coefficients bandPass(double center_hz, double q);
+
+  BiquadFilter() = default;
+  explicit BiquadFilter(const std::vector<Coefficients> &sections);
+
+  /**
+   * @brief Append a section to the end of the cascade.
+   * @param coefficients - The coefficients of the new section.
+   */
+  void addSection(const Coefficients &coefficients);
+
+  /**
+   * @brief Get the number of sections in the cascade.
+   * @return size_t - The number of sections.
+   */
+  size_t getNumSections() const {
+    return sections_.size();
+  }
+
+  using Filter::process;
+  void process(float *samples, size_t num_samples) override;
+  void reset() override;
+
+private:
+  struct Section {
+    Coefficients coefficients{};
+    double z1 = 0.0;
+    double z2 = 0.0;
+  };
+
+  std::vector<Section> sections_{};
+};
+
+/**
+ * @brief A FIR filter.
+ *
+ * Short filters are evaluated directly. Filters longer than
+ * kPartitionSize taps evaluate the first kPartitionSize taps directly and
+ * the rest with a uniformly partitioned FFT convolution. The FFT part only
+ * depends on already completed blocks, so the output is identical to the
+ * direct form (up to rounding) and there is no added latency.
+ */
+class FirFilter : public Filter {
+public:
+  /**
+   * @brief The number of taps evaluated directly and the size of each
+   * partition of the FFT convolution.
+   */
+  static constexpr size_t kPartitionSize = 128;
+
+  /**
+   * @brief Windowed-sinc (Hamming) low pass design.
+   * @param cutoff_hz - The cutoff frequency in Hz.
+   * @param num_taps - The number of taps, should be odd.
+   * @return std::vector<float> - The taps.
+   */
+  static std::vector<float> designLowPass(double cutoff_hz, size_t num_taps);
+
+  /**
+   * @brief Windowed-sinc (Hamming) band pass design.
+   * @param low_hz - The lower edge of the pass band in Hz.
+   * @param high_hz - The upper edge of the pass band in Hz.
+   * @param num_taps - The number of taps, should be odd.
+   * @return std::vector<float> - The taps.
+   */
+  static std::vector<float> designBandPass(double low_hz, double high_hz,
+                                           size_t num_taps);
+
+  /**
+   * @param taps - The impulse response of the filter, must not be empty.
+   */
+  explicit FirFilter(const std::vector<float> &taps);
+  ~FirFilter();
+
+  FirFilter(const FirFilter &) = delete;
+  FirFilter &operator=(const FirFilter &) = delete;
+
+  /**
+   * @brief Get the number of taps.
+   * @return size_t - The number of taps.
+   */
+  size_t getNumTaps() const {
+    return num_taps_;
+  }
+
+  /**
+   * @brief Check if the partitioned convolution path is in use.
+   * @return true - The filter is longer than kPartitionSize taps.
+   */
+  bool isPartitioned() const {
+    return !partitions_.empty();
+  }
+
+  using Filter::process;
+  void process(float *samples, size_t num_samples) override;
+  void reset() override;
+
+private:
+  using Complex = std::complex<float>;
+
+  void processDirect(float *samples, size_t num_samples);
+  void computeTailBlock();
+  void pushInputBlock();
+
+  size_t num_taps_;
+
+  /**
+   * @brief The directly evaluated taps, reversed so that each output is a
+   * contiguous dot product with the history buffer.
+   */
+  std::vector<float> head_taps_{};
+
+  /**
+   * @brief The last head_taps_.size() - 1 inputs followed by the current
+   * chunk of input.
+   */
+  std::vector<float> history_{};
+
+  // Partitioned convolution state, only used when isPartitioned().
+  std::unique_ptr<Fft> fft_;
+  std::vector<std::vector<Complex>> partitions_{};
+  std::vector<std::vector<Complex>> spectra_{};
+  size_t newest_spectrum_ = 0;
+  std::vector<float> previous_block_{};
+  std::vector<float> current_block_{};
+  std::vector<float> tail_output_{};
+  std::vector<Complex> scratch_{};
+  size_t block_position_ = 0;
+};
+
+} // namespace wavgen
+
+#endif /* WAV_FILTER_HPP_ */
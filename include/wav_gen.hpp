@@ -9,12 +9,22 @@
 #ifndef WAV_FILE_HPP_
 #define WAV_FILE_HPP_
 
+#include <array>
+#include <chrono>
 #include <cstdint>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace wavgen {
 
+class Filter;
+class Overview;
+class ToneCache;
+
 /**
  * @brief The sample rate of the WAV file.
  */
@@ -35,6 +45,17 @@ inline constexpr uint16_t SINE_WAVE_SAMPLES_TO_FILTER = 150;
  */
 inline constexpr uint32_t SAMPLE_RATE_MS = SAMPLE_RATE / 1000;
 
+/**
+ * @brief The maximum number of tones Generator::addMultiTone() can sum.
+ */
+inline constexpr size_t MAX_MULTI_TONES = 16;
+
+/**
+ * @brief The number of samples the Writer buffers before writing them to the
+ * file. Filters attached to a Writer see blocks of (at most) this size.
+ */
+inline constexpr uint32_t WRITER_BUFFER_SIZE = 4096;
+
 /**
  * @brief The base class for WAV files.
  *
@@ -48,7 +69,7 @@ public:
    * @brief Returns the sample rate of the WAV file.
    * @return uint32_t - The sample rate.
    */
-  uint32_t getSampleRate() const {
+  virtual uint32_t getSampleRate() const {
     return SAMPLE_RATE;
   }
 
@@ -56,7 +77,7 @@ public:
    * @brief Get the number of bits per sample.
    * @return uint32_t - The number of bits per sample.
    */
-  uint32_t getBitsPerSample() const {
+  virtual uint32_t getBitsPerSample() const {
     return SAMPLE_RESOLUTION;
   }
 
@@ -79,22 +100,104 @@ public:
   virtual uint32_t getFileSize() = 0;
 };
 
+/**
+ * @brief The result of a Writer or Generator operation.
+ *
+ * Errors are recorded in the writer, see Writer::getStatus(). Normally they
+ * are also thrown as std::runtime_error. When the library is built with the
+ * WAVGEN_NO_EXCEPTIONS option nothing is thrown, the status is the only
+ * report and the failed operation is skipped.
+ */
+enum class Status : uint8_t {
+  OK = 0,
+  NOT_OPEN,         // No file is open.
+  OPEN_FAILED,      // The file could not be opened or created.
+  WRITE_FAILED,     // Writing to the file failed, buffered samples are lost.
+  INVALID_ARGUMENT  // A parameter is out of range, nothing was added.
+};
+
+/**
+ * @brief When a Writer updates the header of the file while it is being
+ * written, so that a file that is never finished with done() (a crash, a
+ * power loss) still has a valid header covering most of its samples.
+ *
+ * Checkpoints are only taken when the sample buffer is written to the file,
+ * so they are at most every WRITER_BUFFER_SIZE samples.
+ */
+struct CheckpointPolicy {
+  /**
+   * @brief Update the header after this many new samples, 0 to disable.
+   */
+  uint32_t every_samples = 0;
+
+  /**
+   * @brief Update the header after this many milliseconds, 0 to disable.
+   */
+  uint32_t every_ms = 0;
+};
+
 /**
  * @brief A class to write WAV files.
  */
 class Writer : public WavFile {
 public:
+  /**
+   * @brief Create a writer without a file, call open() before adding
+   * samples.
+   */
+  Writer();
+
   /**
    * @brief Open a WAV file for writing.
    * @param output_file_path - The name of the file to write to.
    */
   Writer(std::string output_file_path);
 
+  /**
+   * @brief Create a writer that buffers samples in a caller provided buffer
+   * instead of allocating one. The buffer must outlive the writer.
+   *
+   * @param buffer - The sample buffer.
+   * @param buffer_size - The number of samples the buffer holds, at least 1.
+   */
+  Writer(int16_t *buffer, uint32_t buffer_size);
+
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  Writer(Writer &&other);
+
+  /**
+   * @brief Move assignment, calls done() on the current file if it is open.
+   */
+  Writer &operator=(Writer &&other);
+
   /**
    * @brief Deconstructor for the WAV file writer. This will call done().
    */
   ~Writer();
 
+  /**
+   * @brief Open a new file for writing, reusing the sample buffer. If a file
+   * is already open, done() is called on it first.
+   * @param output_file_path - The name of the file to write to.
+   */
+  void open(std::string output_file_path);
+
+  /**
+   * @brief Write to an already open, seekable POSIX file descriptor (a file,
+   * a block device). The header is written at offset 0 and the samples
+   * after it. The writer does not close the descriptor.
+   * @param fd - The file descriptor to write to.
+   */
+  void open(int fd);
+
+  /**
+   * @brief Check if a file is open for writing.
+   * @return true - A file is open.
+   */
+  bool isOpen() const;
+
   uint32_t getNumSamples() override;
   uint32_t getDuration() override;
   uint32_t getFileSize() override;
@@ -111,20 +214,240 @@ public:
    */
   void addSample(double sample);
 
+  /**
+   * @brief Add a block of samples to the WAV file.
+   * @param samples - The 16-bit signed samples to add.
+   * @param num_samples - The number of samples to add.
+   */
+  void addSamples(const int16_t *samples, uint32_t num_samples);
+
+  /**
+   * @brief Set the number of channels of the file. This must be done before
+   * any samples are added, the samples of addSample() and addSamples() are
+   * then interleaved frames. Filters and overviews only support mono files,
+   * more than one channel fails with Status::INVALID_ARGUMENT while either
+   * is attached.
+   * @param num_channels - The number of channels, at least 1.
+   */
+  void setNumChannels(uint16_t num_channels);
+
+  uint16_t getNumChannels() const {
+    return num_channels_;
+  }
+
+  /**
+   * @brief Add frames from planar buffers, one per channel, interleaving
+   * them straight into the sample buffer.
+   *
+   * @param channels - getNumChannels() pointers to num_frames samples each.
+   * @param num_frames - The number of samples to add to each channel.
+   */
+  void addFrames(const int16_t *const *channels, uint32_t num_frames);
+
+  /**
+   * @brief Attach a filter that is applied to each buffered block of samples
+   * right before it is written to the file. The writer does not take
+   * ownership, the filter must outlive the writer (or be detached). Only
+   * mono files can be filtered, attaching a filter to a writer with more
+   * than one channel fails with Status::INVALID_ARGUMENT.
+   * @param filter - The filter to use, or nullptr to remove it.
+   */
+  void setFilter(Filter *filter);
+
+  /**
+   * @brief Set when the header is updated while the file is being written.
+   * @param policy - The checkpoint policy.
+   */
+  void setCheckpointPolicy(const CheckpointPolicy &policy);
+
+  /**
+   * @brief Update the header to cover the samples that have been written to
+   * the file so far. This is a single positioned write of the header, it
+   * does not write the buffered samples or move the append position.
+   */
+  void checkpoint();
+
+  /**
+   * @brief Build an overview of the samples as they are written. When the
+   * file is done it is saved as a sidecar, at Overview::sidecarPath(). If
+   * the sidecar can not be written done() fails with Status::WRITE_FAILED,
+   * the WAV file itself is complete. Overviews are only built for mono
+   * files, this fails with Status::INVALID_ARGUMENT after setNumChannels()
+   * with more than one channel.
+   */
+  void enableOverview();
+
+  /**
+   * @brief Get the first error since the writer was created or the status
+   * was cleared.
+   * @return Status - Status::OK if there was no error.
+   */
+  Status getStatus() const {
+    return status_;
+  }
+
+  /**
+   * @brief Reset the status to Status::OK.
+   */
+  void clearStatus() {
+    status_ = Status::OK;
+  }
+
+  /**
+   * @brief Get the overview of the samples written so far.
+   * @return const Overview* - The overview, or nullptr if it is not enabled.
+   */
+  const Overview *getOverview() const {
+    return overview_.get();
+  }
+
   /**
    * @brief Save the file and close it.
    */
   void done();
 
+protected:
+  /**
+   * @brief Record an error, and throw it unless exceptions are disabled.
+   * @param status - The error.
+   * @param message - The message of the exception.
+   */
+  void fail(Status status, const char *message);
+
 private:
-  std::ofstream wav_file_{};
+  /**
+   * @brief Filter and write the buffered samples to the file.
+   */
+  void flush();
+
+  /**
+   * @brief The file descriptor of the open file, -1 if not open.
+   */
+  int fd_ = -1;
+
+  /**
+   * @brief Close the file descriptor in done(), false if it is the caller's.
+   */
+  bool owns_fd_ = false;
+
+  /**
+   * @brief The sample buffer, either owned_buffer_ or the caller's.
+   */
+  int16_t *buffer_ = nullptr;
+  uint32_t buffer_size_ = 0;
+  uint32_t buffered_samples_ = 0;
+  std::vector<int16_t> owned_buffer_{};
+
+  uint16_t num_channels_ = 1;
+
+  /**
+   * @brief The number of samples added, of all channels.
+   */
+  uint32_t num_samples_ = 0;
+
+  /**
+   * @brief The number of samples that have been written to the file, of all
+   * channels.
+   */
+  uint32_t samples_written_ = 0;
+
+  Filter *filter_ = nullptr;
+
+  CheckpointPolicy checkpoint_policy_{};
+  uint32_t checkpoint_samples_ = 0;
+  std::chrono::steady_clock::time_point checkpoint_time_{};
+
+  std::string file_path_{};
+  std::unique_ptr<Overview> overview_{};
+
+  Status status_ = Status::OK;
+};
+
+/**
+ * @brief A single tone of a multi-tone signal.
+ */
+struct Tone {
+  /**
+   * @brief The frequency of the tone in Hz.
+   */
+  double frequency = 0.0;
+
+  /**
+   * @brief The amplitude of the tone (0.0 - 1.0). The tones are summed, so
+   * the sum of the amplitudes should not exceed 1.0 to avoid clipping.
+   */
+  double amplitude = 0.0;
+};
+
+/**
+ * @brief How the frequency of a sweep changes over time.
+ */
+enum class SweepShape {
+  /**
+   * @brief The frequency changes by the same number of Hz every sample.
+   */
+  LINEAR,
+
+  /**
+   * @brief The frequency changes by the same ratio every sample, so each
+   * octave takes the same time.
+   */
+  EXPONENTIAL
+};
+
+/**
+ * @brief Statistics of the Generator tone cache.
+ */
+struct ToneCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+
+  /**
+   * @brief The number of bytes of samples currently cached.
+   */
+  size_t bytes = 0;
+
+  /**
+   * @brief The number of segments currently cached.
+   */
+  size_t entries = 0;
+
+  /**
+   * @brief Get the fraction of lookups that were hits.
+   * @return double - The hit rate (0.0 - 1.0).
+   */
+  double getHitRate() const {
+    const uint64_t lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+  }
 };
 
 class Generator : public Writer {
 public:
-  Generator(std::string output_file_path) : Writer(output_file_path) {
-  }
-  ~Generator() = default;
+  /**
+   * @brief Create a generator without a file, call open() before adding
+   * samples.
+   */
+  Generator();
+  Generator(std::string output_file_path);
+
+  /**
+   * @brief Create a generator that buffers samples in a caller provided
+   * buffer, see Writer::Writer(int16_t *, uint32_t).
+   */
+  Generator(int16_t *buffer, uint32_t buffer_size);
+  ~Generator();
+
+  Generator(Generator &&other);
+  Generator &operator=(Generator &&other);
+
+  /**
+   * @brief Reset the oscillator phases and the noise position so the next
+   * file starts from the same state as a new generator. The noise seed and
+   * the tone cache are kept.
+   */
+  void reset();
 
   /**
    * @brief Add a sine wave to the WAV file with a given frequency, amplitude,
@@ -146,15 +469,314 @@ public:
   void addSineWaveSamples(uint16_t frequency, double amplitude,
                           uint32_t samples);
 
+  /**
+   * @brief Add a sine wave that sweeps from one frequency to another.
+   *
+   * The first sample is at start_hz and the last at end_hz, frequencies may
+   * be fractional. The sweep continues from the phase of the previous
+   * addSineWave(), addSineWaveSamples() or addSweep() call, so sweeps and
+   * tones can be chained without discontinuities. There is no fade in or
+   * out. A sweep with start_hz equal to end_hz is a constant tone.
+   *
+   * @param start_hz - The frequency of the first sample in Hz.
+   * @param end_hz - The frequency of the last sample in Hz.
+   * @param amplitude - The amplitude of the sine wave (0.0 - 1.0)
+   * @param samples - The number of samples to add to the WAV file.
+   * @param shape - Linear or exponential, exponential sweeps need
+   * frequencies above 0.
+   */
+  void addSweep(double start_hz, double end_hz, double amplitude,
+                uint32_t samples, SweepShape shape = SweepShape::LINEAR);
+
+  /**
+   * @brief Enable caching of rendered addSineWave() and addSineWaveSamples()
+   * segments. A segment that was already rendered with the same parameters
+   * and starting phase is copied instead of synthesized again.
+   *
+   * While the cache is enabled the starting phase of each segment is rounded
+   * to one of 4096 steps (an error of at most 0.00077 radians), so the output
+   * is the same whether a segment is a hit or a miss.
+   *
+   * @param max_bytes - The maximum size of the cached samples in bytes. The
+   * least recently used segments are evicted when it is exceeded. Segments
+   * larger than this are rendered directly and not counted as lookups.
+   */
+  void enableToneCache(size_t max_bytes);
+
+  /**
+   * @brief Disable the tone cache and free the cached segments.
+   */
+  void disableToneCache();
+
+  /**
+   * @brief Get the tone cache statistics.
+   * @return ToneCacheStats - The statistics, all zero if it is not enabled.
+   */
+  ToneCacheStats getToneCacheStats() const;
+
+  /**
+   * @brief Add silence to the WAV file.
+   *
+   * @param samples - The number of samples to add to the WAV file.
+   */
+  void addSilence(uint32_t samples);
+
+  /**
+   * @brief Add the sum of several sine waves, rendered in a single pass.
+   *
+   * Each tone has its own persistent phase, identified by its index in the
+   * list, so consecutive calls with the same list produce continuous tones.
+   * At most MAX_MULTI_TONES tones are supported.
+   *
+   * @param tones - The tones to sum.
+   * @param num_tones - The number of tones.
+   * @param samples - The number of samples to add to the WAV file.
+   */
+  void addMultiTone(const Tone *tones, size_t num_tones, uint32_t samples);
+
+  /**
+   * @brief Add the sum of several sine waves, rendered in a single pass.
+   *
+   * @param tones - The tones to sum.
+   * @param samples - The number of samples to add to the WAV file.
+   */
+  void addMultiTone(const std::vector<Tone> &tones, uint32_t samples);
+
+  /**
+   * @brief Add a sequence of DTMF digits. If any digit is invalid this
+   * fails with Status::INVALID_ARGUMENT and adds nothing.
+   *
+   * @param digits - The digits to add (0-9, A-D, * and #).
+   * @param tone_ms - The duration of each digit in milliseconds.
+   * @param gap_ms - The duration of the silence after each digit.
+   * @param amplitude - The peak amplitude of each digit (0.0 - 1.0)
+   */
+  void addDtmf(const std::string &digits, uint16_t tone_ms, uint16_t gap_ms,
+               double amplitude = 0.5);
+
+  /**
+   * @brief Set the seed of the noise sources and rewind them to the start of
+   * the noise sequence. The same seed always produces the same noise.
+   *
+   * @param seed - The seed.
+   */
+  void setNoiseSeed(uint64_t seed);
+
+  /**
+   * @brief Set the position in the noise sequence. Each noise sample only
+   * depends on the seed and its position, so a long render can be split
+   * across several generators (or threads) and still produce exactly the
+   * same samples as a single generator.
+   *
+   * @param position - The index of the next noise sample.
+   */
+  void setNoisePosition(uint64_t position);
+
+  /**
+   * @brief Get the position in the noise sequence.
+   * @return uint64_t - The index of the next noise sample.
+   */
+  uint64_t getNoisePosition() const {
+    return noise_position_;
+  }
+
+  /**
+   * @brief Add uniformly distributed white noise.
+   *
+   * @param amplitude - The peak amplitude of the noise (0.0 - 1.0)
+   * @param samples - The number of samples to add to the WAV file.
+   */
+  void addWhiteNoise(double amplitude, uint32_t samples);
+
+  /**
+   * @brief Add gaussian white noise. Samples beyond full scale are clipped.
+   *
+   * @param rms - The standard deviation of the noise relative to full scale.
+   * @param samples - The number of samples to add to the WAV file.
+   */
+  void addGaussianNoise(double rms, uint32_t samples);
+
+  /**
+   * @brief Add pink (1/f) noise using the Voss-McCartney algorithm.
+   *
+   * @param amplitude - The peak amplitude of the noise (0.0 - 1.0)
+   * @param samples - The number of samples to add to the WAV file.
+   */
+  void addPinkNoise(double amplitude, uint32_t samples);
+
+  /**
+   * @brief Add gaussian noise limited to a frequency band. The filter starts
+   * from rest on each call, so unlike the other noise sources the output
+   * depends on how a render is split into calls.
+   *
+   * A band outside of 0 Hz to SAMPLE_RATE / 2, or with low_hz not below
+   * high_hz, fails with Status::INVALID_ARGUMENT and adds nothing.
+   *
+   * @param low_hz - The lower edge of the band in Hz.
+   * @param high_hz - The upper edge of the band in Hz.
+   * @param rms - The approximate standard deviation of the filtered noise
+   * relative to full scale.
+   * @param samples - The number of samples to add to the WAV file.
+   */
+  void addBandLimitedNoise(double low_hz, double high_hz, double rms,
+                           uint32_t samples);
+
 private:
   /**
    * @brief The angle of the sine wave, persistent to get a continuous wave.
    */
   double wave_angle_ = 0.0f;
+
+  /**
+   * @brief The phase of each tone of addMultiTone(), by index.
+   */
+  std::array<double, MAX_MULTI_TONES> tone_angles_{};
+
+  std::unique_ptr<ToneCache> tone_cache_;
+
+  uint64_t noise_seed_ = 0;
+  uint64_t noise_position_ = 0;
+};
+
+/**
+ * @brief The encoding of the samples of a WAV file.
+ */
+enum class SampleFormat { PCM_8, PCM_16, PCM_24, PCM_32, FLOAT_32 };
+
+/**
+ * @brief The format of a WAV file that is read.
+ */
+struct WavFormat {
+  SampleFormat sample_format = SampleFormat::PCM_16;
+  uint16_t num_channels = 1;
+  uint32_t sample_rate = SAMPLE_RATE;
+};
+
+/**
+ * @brief How a Reader returns the channels of a multichannel file.
+ */
+enum class ChannelMode {
+  /**
+   * @brief One value per channel for each sample, in file order.
+   */
+  INTERLEAVED,
+
+  /**
+   * @brief The average of all channels, one value per sample.
+   */
+  DOWNMIX
+};
+
+class Reader;
+
+/**
+ * @brief A block of samples read from a file. The samples are only valid
+ * until the next block is read.
+ */
+struct SampleBlock {
+  const int16_t *samples = nullptr;
+  uint32_t num_samples = 0;
+
+  /**
+   * @brief The index of the first sample of the block within the file.
+   */
+  uint32_t first_sample = 0;
+
+  const int16_t *begin() const {
+    return samples;
+  }
+
+  const int16_t *end() const {
+    return samples + num_samples;
+  }
+
+  uint32_t size() const {
+    return num_samples;
+  }
+
+  int16_t operator[](uint32_t index) const {
+    return samples[index];
+  }
+};
+
+/**
+ * @brief The samples of a file as a range of blocks, see Reader::blocks().
+ * All blocks are read into the same buffer, memory use does not depend on
+ * the length of the file.
+ */
+class BlockRange {
+public:
+  class Iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = SampleBlock;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const SampleBlock *;
+    using reference = const SampleBlock &;
+
+    const SampleBlock &operator*() const {
+      return range_->block_;
+    }
+
+    const SampleBlock *operator->() const {
+      return &range_->block_;
+    }
+
+    Iterator &operator++() {
+      if (!range_->next()) {
+        range_ = nullptr;
+      }
+      return *this;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return range_ == other.range_;
+    }
+
+    bool operator!=(const Iterator &other) const {
+      return range_ != other.range_;
+    }
+
+  private:
+    friend class BlockRange;
+    explicit Iterator(BlockRange *range) : range_(range) {
+    }
+
+    BlockRange *range_;
+  };
+
+  /**
+   * @brief Read the first block, there is only one pass over the file.
+   */
+  Iterator begin();
+
+  Iterator end() {
+    return Iterator(nullptr);
+  }
+
+private:
+  friend class Reader;
+  BlockRange(Reader &reader, uint32_t block_size);
+
+  /**
+   * @brief Read the block after the current one.
+   * @return bool - False at the end of the file.
+   */
+  bool next();
+
+  Reader &reader_;
+  uint32_t block_size_;
+  std::vector<int16_t> buffer_{};
+  SampleBlock block_{};
+  bool started_ = false;
 };
 
 /**
  * @brief A class to read WAV files.
+ *
+ * Any PCM file of 8, 16, 24 or 32-bit integer or 32-bit float samples can be
+ * opened, with any number of channels and any sample rate. The 16-bit
+ * getAllSamples() only reads 16-bit mono files, read() decodes every format.
  */
 class Reader : public WavFile {
 public:
@@ -165,19 +787,171 @@ public:
    */
   Reader(std::string input_file_path);
 
+  Reader(const Reader &) = delete;
+  Reader &operator=(const Reader &) = delete;
+
   /**
    * @brief Deconstructor for the WAV file reader.
    */
-  ~Reader() = default;
+  ~Reader();
 
+  /**
+   * @brief Get the number of samples in the WAV file. For a multichannel
+   * file this is the number of samples of each channel.
+   */
   uint32_t getNumSamples() override;
   uint32_t getDuration() override;
   uint32_t getFileSize() override;
 
+  uint32_t getSampleRate() const override {
+    return format_.sample_rate;
+  }
+
+  uint32_t getBitsPerSample() const override;
+
+  /**
+   * @brief Get the format of the file.
+   * @return const WavFormat& - The sample format, channels and sample rate.
+   */
+  const WavFormat &getFormat() const {
+    return format_;
+  }
+
+  /**
+   * @brief Read all samples of a 16-bit mono file.
+   *
+   * @param samples - Resized to the number of samples and filled.
+   * @throws std::runtime_error - If the file is not 16-bit mono.
+   */
   void getAllSamples(std::vector<int16_t> &samples);
 
+  /**
+   * @brief Stream the samples of a 16-bit mono file one block at a time:
+   * @code
+   * for (const auto &block : reader.blocks(4096)) {
+   *   for (int16_t sample : block) { ... }
+   * }
+   * @endcode
+   * While a block is processed the kernel is already reading the next one.
+   *
+   * @param block_size - The number of samples of each block.
+   * @return BlockRange - A single pass range of blocks.
+   * @throws std::runtime_error - If the file is not 16-bit mono.
+   */
+  BlockRange blocks(uint32_t block_size = WRITER_BUFFER_SIZE);
+
+  /**
+   * @brief Call a visitor for each block of samples of a 16-bit mono file.
+   * @see blocks()
+   *
+   * @param visitor - Called for each block in order.
+   * @param block_size - The number of samples of each block.
+   */
+  void visitBlocks(const std::function<void(const SampleBlock &)> &visitor,
+                   uint32_t block_size = WRITER_BUFFER_SIZE);
+
+  /**
+   * @brief Get the overview of a 16-bit mono file. It is loaded from the
+   * sidecar file if there is one for the same number of samples, otherwise
+   * it is built in parallel the first time it is needed.
+   *
+   * @param num_threads - The number of threads to build it with, 0 for one
+   * per hardware thread.
+   * @return const Overview& - The overview, valid while the reader is.
+   */
+  const Overview &getOverview(uint32_t num_threads = 0);
+
+  /**
+   * @brief Decode samples into a caller provided buffer, scaled to the range
+   * [-1, 1]. The file is read in blocks and each block is converted (and
+   * downmixed) in a single pass.
+   *
+   * @param output - The buffer to decode into, num_samples values in
+   * DOWNMIX mode or num_samples * channels values in INTERLEAVED mode.
+   * @param first_sample - The index of the first sample to decode.
+   * @param num_samples - The number of samples to decode.
+   * @param mode - Interleave or downmix the channels of multichannel files.
+   * @return uint32_t - The number of samples decoded, less than num_samples
+   * at the end of the file.
+   */
+  uint32_t read(float *output, uint32_t first_sample, uint32_t num_samples,
+                ChannelMode mode = ChannelMode::DOWNMIX);
+
+  /**
+   * @brief Decode samples into a caller provided buffer, scaled to the range
+   * [-1, 1]. 32-bit integer samples keep their full precision.
+   * @see read(float *, uint32_t, uint32_t, ChannelMode)
+   */
+  uint32_t read(double *output, uint32_t first_sample, uint32_t num_samples,
+                ChannelMode mode = ChannelMode::DOWNMIX);
+
+  /**
+   * @brief Read the samples of a 16-bit file of any number of channels into
+   * planar buffers, one per channel, without converting them.
+   *
+   * @param channels - getFormat().num_channels pointers to buffers of
+   * num_samples samples.
+   * @param first_sample - The index of the first sample to read.
+   * @param num_samples - The number of samples to read from each channel.
+   * @return uint32_t - The number of samples read, less than num_samples at
+   * the end of the file.
+   */
+  uint32_t readPlanar(int16_t *const *channels, uint32_t first_sample,
+                      uint32_t num_samples);
+
+  /**
+   * @brief Attach a filter that is applied to each block of samples as it is
+   * read by getAllSamples() or, for mono output, read() into floats. The
+   * reader does not take ownership.
+   * @param filter - The filter to use, or nullptr to remove it.
+   */
+  void setFilter(Filter *filter);
+
 private:
-  std::ifstream wav_file_{};
+  friend class BlockRange;
+
+  /**
+   * @brief Throw unless the file is 16-bit mono.
+   */
+  void requirePcm16Mono() const;
+
+  /**
+   * @brief Read and filter 16-bit samples, then ask the kernel to start
+   * reading the following samples in the background.
+   * @return uint32_t - The number of samples read.
+   */
+  uint32_t readBlock(int16_t *buffer, uint32_t first_sample,
+                     uint32_t num_samples);
+
+  template <typename T>
+  uint32_t readDecoded(T *output, uint32_t first_sample, uint32_t num_samples,
+                       ChannelMode mode);
+
+  /**
+   * @brief The file descriptor of the open file.
+   */
+  int fd_ = -1;
+
+  WavFormat format_{};
+
+  /**
+   * @brief The size of one sample of every channel in bytes.
+   */
+  uint16_t block_align_ = 0;
+
+  uint64_t data_offset_ = 0;
+  uint32_t data_size_ = 0;
+
+  /**
+   * @brief Undecoded bytes, reused between reads.
+   */
+  std::vector<uint8_t> read_buffer_{};
+  std::vector<int16_t> frame_buffer_{};
+
+  Filter *filter_ = nullptr;
+
+  std::string file_path_{};
+  std::unique_ptr<Overview> overview_{};
 };
 } // namespace wavgen
 
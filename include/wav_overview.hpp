@@ -0,0 +1,151 @@
+/**
+ * @file wav_overview.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief A min/max/RMS pyramid of a WAV file for drawing waveforms.
+ * @date 2023-10-07
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef WAV_OVERVIEW_HPP_
+#define WAV_OVERVIEW_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wavgen {
+
+/**
+ * @brief The number of samples summarized by each bucket of each level of
+ * an overview, finest first.
+ */
+inline constexpr std::array<uint32_t, 3> OVERVIEW_BUCKET_SIZES = {256, 4096,
+                                                                   65536};
+
+/**
+ * @brief The summary of a range of samples.
+ */
+struct OverviewBucket {
+  int16_t min = 0;
+  int16_t max = 0;
+  float rms = 0.0f;
+};
+
+/**
+ * @brief A pyramid of min, max and RMS levels of a 16-bit mono file at each
+ * of the OVERVIEW_BUCKET_SIZES. It can be built as samples are written (see
+ * Writer::enableOverview()), from an existing file (see
+ * Reader::getOverview()), and saved next to the file as a sidecar.
+ */
+class Overview {
+public:
+  Overview();
+
+  /**
+   * @brief Add samples to the end of the overview.
+   *
+   * @param samples - The samples to add.
+   * @param num_samples - The number of samples.
+   */
+  void addSamples(const int16_t *samples, uint32_t num_samples);
+
+  /**
+   * @brief Get the number of samples summarized.
+   */
+  uint32_t getNumSamples() const {
+    return num_samples_;
+  }
+
+  /**
+   * @brief Summarize a range of samples as a number of equal width pixels.
+   *
+   * Each pixel is computed from the coarsest level with at least one bucket
+   * per pixel, so the work depends on the number of pixels and not on the
+   * number of samples. Pixels narrower than the finest bucket repeat the
+   * bucket they fall in, read the samples instead for that zoom level.
+   *
+   * @param first_sample - The first sample of the range.
+   * @param num_samples - The number of samples of the range.
+   * @param num_pixels - The number of pixels to return.
+   * @return std::vector<OverviewBucket> - One bucket per pixel, empty if the
+   * range is outside of the overview.
+   */
+  std::vector<OverviewBucket> query(uint32_t first_sample,
+                                    uint32_t num_samples,
+                                    uint32_t num_pixels) const;
+
+  /**
+   * @brief Write the overview to the sidecar of a WAV file, at
+   * sidecarPath(). The size and modification time of the WAV file are saved
+   * with it, so a sidecar that was not updated with the file is detected.
+   *
+   * @param wav_path - The WAV file the overview summarizes.
+   */
+  void saveSidecar(const std::string &wav_path) const;
+
+  /**
+   * @brief Write the overview to the sidecar of a WAV file, like
+   * saveSidecar(), but report a failure instead of throwing.
+   *
+   * @param wav_path - The WAV file the overview summarizes.
+   * @return bool - False if the WAV file can not be read or the sidecar can
+   * not be written.
+   */
+  bool trySaveSidecar(const std::string &wav_path) const;
+
+  /**
+   * @brief Read the overview from the sidecar of a WAV file.
+   * @param wav_path - The WAV file.
+   * @throws std::runtime_error - If the sidecar is not a valid overview, or
+   * the WAV file changed since the sidecar was saved.
+   */
+  static Overview loadSidecar(const std::string &wav_path);
+
+  /**
+   * @brief Delete the sidecar of a WAV file, if there is one. Called by
+   * functions that modify a WAV file in place.
+   * @param wav_path - The WAV file.
+   */
+  static void removeSidecar(const std::string &wav_path);
+
+  /**
+   * @brief Build the overview of a 16-bit mono WAV file. The file is split
+   * into ranges that are summarized in parallel.
+   *
+   * @param wav_path - The WAV file.
+   * @param num_threads - The number of threads, 0 for one per hardware
+   * thread.
+   */
+  static Overview build(const std::string &wav_path, uint32_t num_threads = 0);
+
+  /**
+   * @brief The path of the sidecar file of a WAV file.
+   */
+  static std::string sidecarPath(const std::string &wav_path) {
+    return wav_path + ".overview";
+  }
+
+private:
+  /**
+   * @brief A bucket as stored, the sum of squares can be merged.
+   */
+  struct Summary {
+    int16_t min = INT16_MAX;
+    int16_t max = INT16_MIN;
+    float sum_of_squares = 0.0f;
+  };
+
+  /**
+   * @brief Append another overview that starts at a multiple of the largest
+   * bucket size.
+   */
+  void append(const Overview &other);
+
+  uint32_t num_samples_ = 0;
+  std::array<std::vector<Summary>, OVERVIEW_BUCKET_SIZES.size()> levels_{};
+};
+
+} // namespace wavgen
+
+#endif /* WAV_OVERVIEW_HPP_ */
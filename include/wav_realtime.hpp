@@ -0,0 +1,197 @@
+/**
+ * @file wav_realtime.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief A pull based generator for real-time audio output.
+ * @date 2023-08-12
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef WAV_REALTIME_HPP_
+#define WAV_REALTIME_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "wav_gen.hpp"
+
+namespace wavgen {
+
+template <typename T> class RingBuffer;
+
+/**
+ * @brief A generator that is driven by the consumer instead of writing to a
+ * file. A control thread queues tones, and the audio thread (a sound card
+ * callback, a transmitter loop, etc.) requests blocks of samples with
+ * render().
+ *
+ * render() does not allocate, lock, or perform I/O, so it runs in bounded
+ * time. When no tone is queued it outputs silence and counts an underrun.
+ *
+ * Optionally the rendered audio can be recorded to a Writer. The audio thread
+ * only copies each block into a lock-free ring buffer, a background thread
+ * drains it into the Writer.
+ */
+class RealtimeGenerator {
+public:
+  /**
+   * @brief Render timing and health counters.
+   */
+  struct Stats {
+    uint64_t blocks_rendered = 0;
+    uint64_t samples_rendered = 0;
+
+    /**
+     * @brief Number of samples that were rendered as silence because the
+     * command queue was empty.
+     */
+    uint64_t underrun_samples = 0;
+
+    /**
+     * @brief Number of samples that could not be recorded because the
+     * recording buffer was full.
+     */
+    uint64_t dropped_recording_samples = 0;
+
+    std::chrono::nanoseconds last_render_time{0};
+    std::chrono::nanoseconds worst_render_time{0};
+    std::chrono::nanoseconds total_render_time{0};
+  };
+
+  /**
+   * @param command_queue_size - The maximum number of queued tones.
+   */
+  explicit RealtimeGenerator(uint32_t command_queue_size = 1024);
+
+  /**
+   * @brief Stops recording, if it was started.
+   */
+  ~RealtimeGenerator();
+
+  RealtimeGenerator(const RealtimeGenerator &) = delete;
+  RealtimeGenerator &operator=(const RealtimeGenerator &) = delete;
+
+  /**
+   * @brief Queue a sine wave. Called from the control thread.
+   *
+   * @param frequency - The frequency of the sine wave in Hz.
+   * @param amplitude - The amplitude of the sine wave (0.0 - 1.0)
+   * @param samples - The number of samples of the sine wave.
+   * @return true - The tone was queued.
+   * @return false - The queue is full.
+   */
+  bool queueSineWave(double frequency, double amplitude, uint32_t samples);
+
+  /**
+   * @brief Queue silence. Called from the control thread.
+   *
+   * @param samples - The number of samples of silence.
+   * @return true - The silence was queued.
+   * @return false - The queue is full.
+   */
+  bool queueSilence(uint32_t samples);
+
+  /**
+   * @brief Get the number of samples that are queued but not yet rendered.
+   * This is approximate while render() is running.
+   * @return uint64_t - The number of queued samples.
+   */
+  uint64_t getQueuedSamples() const;
+
+  /**
+   * @brief Fill a block with the next samples. Called from the audio thread.
+   *
+   * @param block - The block to fill.
+   * @param num_samples - The number of samples in the block.
+   */
+  void render(int16_t *block, uint32_t num_samples);
+
+  /**
+   * @brief A C style callback that calls render(), for audio APIs that take
+   * a function pointer and a user data pointer.
+   *
+   * @param user_data - A pointer to the RealtimeGenerator.
+   * @param block - The block to fill.
+   * @param num_samples - The number of samples in the block.
+   */
+  static void renderCallback(void *user_data, int16_t *block,
+                             uint32_t num_samples);
+
+  /**
+   * @brief Start recording the rendered audio to a Writer. The writer must
+   * outlive the recording, call stopRecording() before calling done() on it.
+   *
+   * @param writer - The writer to record to.
+   * @param buffer_size - The size of the recording buffer in samples,
+   * rounded up to a power of two. The buffer is reallocated if a different
+   * size is requested than for the previous recording.
+   */
+  void startRecording(Writer &writer, uint32_t buffer_size = SAMPLE_RATE);
+
+  /**
+   * @brief Stop recording, writing any samples that are still buffered.
+   */
+  void stopRecording();
+
+  /**
+   * @brief Get a snapshot of the render statistics.
+   * @return Stats - The statistics.
+   */
+  Stats getStats() const;
+
+  /**
+   * @brief Reset the render statistics. The audio thread clears them at the
+   * start of its next render() call, getStats() returns the old values
+   * until then.
+   */
+  void resetStats();
+
+private:
+  struct Command {
+    double d_angle = 0.0;
+    double amplitude = 0.0;
+    uint32_t samples = 0;
+  };
+
+  void recordingLoop();
+
+  std::unique_ptr<RingBuffer<Command>> commands_;
+  std::atomic<uint64_t> queued_samples_{0};
+
+  // Audio thread state.
+  Command current_{};
+  double wave_angle_ = 0.0;
+
+  // Recording state.
+  std::unique_ptr<RingBuffer<int16_t>> recording_buffer_;
+  std::atomic<bool> recording_{false};
+
+  /**
+   * @brief Set by render() while it checks recording_ and pushes a block.
+   */
+  std::atomic<bool> rendering_{false};
+
+  /**
+   * @brief Tells the recording thread to do its final drain and exit.
+   */
+  std::atomic<bool> stop_recording_thread_{false};
+  Writer *recording_writer_ = nullptr;
+  std::thread recording_thread_{};
+
+  // Statistics, only written by the audio thread. resetStats() sets the
+  // flag and render() clears them.
+  std::atomic<bool> reset_stats_{false};
+  std::atomic<uint64_t> blocks_rendered_{0};
+  std::atomic<uint64_t> samples_rendered_{0};
+  std::atomic<uint64_t> underrun_samples_{0};
+  std::atomic<uint64_t> dropped_recording_samples_{0};
+  std::atomic<int64_t> last_render_ns_{0};
+  std::atomic<int64_t> worst_render_ns_{0};
+  std::atomic<int64_t> total_render_ns_{0};
+};
+
+} // namespace wavgen
+
+#endif /* WAV_REALTIME_HPP_ */
@@ -0,0 +1,154 @@
+/**
+ * @file wav_sstv.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Slow scan television (SSTV) image encoding.
+ * @date 2023-10-21
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef WAV_SSTV_HPP_
+#define WAV_SSTV_HPP_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "wav_gen.hpp"
+#include "wav_timeline.hpp"
+
+namespace wavgen {
+
+/**
+ * @brief The supported SSTV modes.
+ */
+enum class SstvMode { ROBOT_36, ROBOT_72, MARTIN_1, MARTIN_2, SCOTTIE_1,
+                      SCOTTIE_2 };
+
+/**
+ * @brief The parameters of an SSTV mode.
+ */
+struct SstvModeInfo {
+  /**
+   * @brief The code sent in the VIS header to identify the mode.
+   */
+  uint8_t vis_code = 0;
+  uint16_t width = 0;
+  uint16_t height = 0;
+
+  /**
+   * @brief The exact length of one scanline.
+   */
+  Duration line_duration{};
+};
+
+/**
+ * @brief Get the parameters of an SSTV mode.
+ */
+SstvModeInfo getSstvModeInfo(SstvMode mode);
+
+/**
+ * @brief Encodes RGB images as SSTV audio.
+ *
+ * Each scanline is turned into a list of constant frequency runs, one per
+ * pixel, sync pulse and porch, and then rendered as a whole with a rotating
+ * phasor, so no sin() is computed per sample. Run boundaries are rounded
+ * from their exact time since the start of the transmission, so the timing
+ * does not drift, and the phase is continuous over the whole image.
+ *
+ * @code
+ * wavgen::Generator generator("image.wav");
+ * wavgen::SstvEncoder encoder(wavgen::SstvMode::MARTIN_1);
+ * encoder.addImage(generator, rgb.data(), rgb.size()); // 320 * 256 * 3
+ * generator.done();
+ * @endcode
+ */
+class SstvEncoder {
+public:
+  /**
+   * @brief Create an encoder.
+   * @param mode - The SSTV mode to encode with.
+   * @param amplitude - The amplitude of the signal (0.0 - 1.0)
+   */
+  explicit SstvEncoder(SstvMode mode, double amplitude = 0.5);
+
+  const SstvModeInfo &getModeInfo() const {
+    return info_;
+  }
+
+  /**
+   * @brief Add the calibration header and the VIS code of the mode.
+   * @param writer - The writer (or Generator) to add the samples to.
+   */
+  void addHeader(Writer &writer);
+
+  /**
+   * @brief Add the next scanline of the image.
+   *
+   * @param writer - The writer (or Generator) to add the samples to.
+   * @param rgb - width pixels of 8-bit interleaved red, green and blue.
+   */
+  void addLine(Writer &writer, const uint8_t *rgb);
+
+  /**
+   * @brief Add the header followed by every scanline of an image.
+   *
+   * @param writer - The writer (or Generator) to add the samples to.
+   * @param rgb - width * height pixels of 8-bit interleaved red, green and
+   * blue, row by row.
+   * @param size - The size of the image in bytes, width * height * 3.
+   */
+  void addImage(Writer &writer, const uint8_t *rgb, size_t size);
+
+private:
+  /**
+   * @brief The phase increment of a tone and the phasor rotation for it.
+   */
+  struct Step {
+    double d_angle = 0.0;
+    float real = 1.0f;
+    float imag = 0.0f;
+  };
+
+  /**
+   * @brief A number of samples of one tone, an index into steps_.
+   */
+  struct Run {
+    uint32_t num_samples = 0;
+    uint16_t tone = 0;
+  };
+
+  void addTone(uint16_t tone, uint64_t duration_ns);
+  void addScan(const uint8_t *levels, size_t stride, uint16_t num_pixels,
+               uint64_t pixel_ns);
+  void addRobotLine(const uint8_t *rgb);
+  void render(Writer &writer);
+
+  SstvMode mode_;
+  SstvModeInfo info_{};
+  double amplitude_ = 0.5;
+
+  /**
+   * @brief Pixel levels 0 - 255 (1500 - 2300 Hz) followed by the sync and
+   * VIS tones.
+   */
+  std::array<Step, 260> steps_{};
+
+  std::vector<Run> runs_{};
+  std::vector<uint8_t> levels_{};
+  std::vector<float> wave_{};
+  std::vector<int16_t> samples_{};
+
+  /**
+   * @brief The time since the start of the transmission in nanoseconds, and
+   * the number of samples rendered so far.
+   */
+  uint64_t time_ns_ = 0;
+  uint64_t num_samples_ = 0;
+
+  uint32_t line_ = 0;
+  double angle_ = 0.0;
+};
+
+} // namespace wavgen
+
+#endif /* WAV_SSTV_HPP_ */
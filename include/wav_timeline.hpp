@@ -0,0 +1,152 @@
+/**
+ * @file wav_timeline.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Sample accurate schedules of tones and silence.
+ * @date 2023-10-14
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef WAV_TIMELINE_HPP_
+#define WAV_TIMELINE_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "wav_gen.hpp"
+
+namespace wavgen {
+
+/**
+ * @brief An exact length of time in seconds, numerator / denominator.
+ */
+struct Duration {
+  uint64_t numerator = 0;
+  uint64_t denominator = 1;
+
+  /**
+   * @brief A number of samples at SAMPLE_RATE.
+   */
+  static Duration samples(uint64_t num_samples) {
+    return {num_samples, SAMPLE_RATE};
+  }
+
+  /**
+   * @brief numerator / denominator seconds, for example seconds(1, 1200) for
+   * one 1200 baud symbol.
+   */
+  static Duration seconds(uint64_t numerator, uint64_t denominator = 1) {
+    return {numerator, denominator};
+  }
+
+  static Duration milliseconds(uint64_t milliseconds) {
+    return {milliseconds, 1000};
+  }
+};
+
+/**
+ * @brief A schedule of tones and silence that is rendered sample accurately.
+ *
+ * Segments are appended at a cursor that is kept as an exact fraction of a
+ * second. The first and last sample of each segment are rounded from its
+ * exact start and end time, so segments that are not a whole number of
+ * samples long do not drift: the fractional remainder is carried into the
+ * next segment. Tones are phase continuous from one segment to the next.
+ *
+ * @code
+ * wavgen::Timeline timeline;
+ * for (bool bit : bits) {
+ *   timeline.addTone(bit ? 1200.0 : 2200.0, 0.5, Duration::seconds(1, 1200));
+ * }
+ * timeline.renderTo(generator);
+ * @endcode
+ */
+class Timeline {
+public:
+  /**
+   * @brief Append a tone at the cursor.
+   *
+   * @param frequency - The frequency in Hz, may be fractional.
+   * @param amplitude - The amplitude (0.0 - 1.0)
+   * @param duration - The length of the tone.
+   */
+  void addTone(double frequency, double amplitude, Duration duration);
+
+  /**
+   * @brief Append silence at the cursor.
+   * @param duration - The length of the silence.
+   */
+  void addSilence(Duration duration);
+
+  /**
+   * @brief Get the exact time of the cursor, the end of the last segment.
+   * The fraction is kept in lowest terms.
+   */
+  Duration getCursor() const {
+    return cursor_;
+  }
+
+  /**
+   * @brief Get the total number of samples of the schedule.
+   */
+  uint64_t getNumSamples() const;
+
+  /**
+   * @brief Get the number of samples that have not been rendered yet.
+   */
+  uint64_t getRemainingSamples() const {
+    return getNumSamples() - position_;
+  }
+
+  /**
+   * @brief Render the next samples into a caller provided block. A single
+   * call renders as many segments as fit into the block.
+   *
+   * @param output - The block to render into.
+   * @param num_samples - The size of the block.
+   * @return uint32_t - The number of samples rendered, less than num_samples
+   * at the end of the schedule.
+   */
+  uint32_t render(int16_t *output, uint32_t num_samples);
+
+  /**
+   * @brief Render the rest of the schedule to a writer, one block at a time.
+   * @param writer - The writer (or Generator) to add the samples to.
+   */
+  void renderTo(Writer &writer);
+
+  /**
+   * @brief Remove all segments and rewind to the start.
+   */
+  void clear();
+
+private:
+  struct Segment {
+    uint64_t end_sample = 0;
+    double d_angle = 0.0;
+    double amplitude = 0.0;
+    bool silent = true;
+  };
+
+  /**
+   * @brief Move the cursor and return the sample it now rounds to.
+   */
+  uint64_t advance(Duration duration);
+
+  std::vector<Segment> segments_{};
+  Duration cursor_{};
+
+  /**
+   * @brief The next sample to render and the segment it is in.
+   */
+  uint64_t position_ = 0;
+  size_t segment_ = 0;
+
+  /**
+   * @brief The phase of the tones, continuous between segments.
+   */
+  double angle_ = 0.0;
+};
+
+} // namespace wavgen
+
+#endif /* WAV_TIMELINE_HPP_ */
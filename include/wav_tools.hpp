@@ -0,0 +1,264 @@
+/**
+ * @file wav_tools.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Operations on whole WAV files.
+ * @date 2023-09-02
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef WAV_TOOLS_HPP_
+#define WAV_TOOLS_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wavgen {
+
+/**
+ * @brief The level of the samples of a WAV file.
+ */
+struct LevelStats {
+  uint32_t num_samples = 0;
+
+  /**
+   * @brief The largest absolute sample value.
+   */
+  int32_t peak = 0;
+
+  /**
+   * @brief The RMS of the samples, in sample units.
+   */
+  double rms = 0.0;
+};
+
+/**
+ * @brief Measure the peak and RMS level of a WAV file. The file is streamed
+ * in blocks, memory use does not depend on its length.
+ *
+ * @param file_path - The file to measure.
+ * @return LevelStats - The levels.
+ */
+LevelStats measureLevels(const std::string &file_path);
+
+enum class NormalizeMode {
+  /**
+   * @brief Scale so the largest sample reaches the target.
+   */
+  PEAK,
+
+  /**
+   * @brief Scale so the RMS reaches the target. Samples that would exceed
+   * full scale are clipped.
+   */
+  RMS
+};
+
+/**
+ * @brief The result of normalizing a file.
+ */
+struct NormalizeResult {
+  /**
+   * @brief The levels before normalizing.
+   */
+  LevelStats before{};
+
+  /**
+   * @brief The gain that was applied.
+   */
+  double gain = 1.0;
+};
+
+/**
+ * @brief Normalize a WAV file in place, in two streaming passes. The first
+ * pass measures the levels, the second rewrites the data chunk with the gain
+ * applied (through a memory mapping, or block reads and writes if the file
+ * can not be mapped). The file is never loaded into memory as a whole.
+ *
+ * A silent file is left unchanged. Otherwise the overview sidecar of the
+ * file, if there is one, is removed.
+ *
+ * @param file_path - The file to normalize.
+ * @param mode - Normalize the peak or the RMS level.
+ * @param target - The target level relative to MAX_SAMPLE_AMPLITUDE
+ * (0.0 - 1.0).
+ * @return NormalizeResult - The measured levels and the applied gain.
+ */
+NormalizeResult normalize(const std::string &file_path,
+                          NormalizeMode mode = NormalizeMode::PEAK,
+                          double target = 1.0);
+
+/**
+ * @brief The result of recovering a file.
+ */
+struct RecoverResult {
+  /**
+   * @brief The number of samples (frames) per channel in the recovered
+   * file.
+   */
+  uint32_t num_samples = 0;
+
+  /**
+   * @brief True if the header already matched the length of the file, in
+   * which case the file was not modified.
+   */
+  bool was_consistent = false;
+
+  /**
+   * @brief The number of trailing bytes that were removed (a partially
+   * written frame).
+   */
+  uint32_t bytes_truncated = 0;
+};
+
+/**
+ * @brief Repair a WAV file that was not finished with Writer::done(), for
+ * example after a crash. A partially written trailing frame is truncated
+ * and the sizes in the header are rewritten to cover all of the frames in
+ * the file, with a single positioned write. Files with any number of
+ * channels can be recovered.
+ *
+ * @param file_path - The file to recover.
+ * @return RecoverResult - What was recovered.
+ * @throws std::runtime_error - If the file is shorter than a header or the
+ * header is not a valid header written by Writer.
+ */
+RecoverResult recoverFile(const std::string &file_path);
+
+/**
+ * @brief Join 16-bit mono files into a new file.
+ *
+ * Only a new header is written, the samples are copied between the files by
+ * the kernel (copy_file_range(), which shares extents on filesystems that
+ * support reflinks, with a sendfile() fallback), so they never pass through
+ * user space.
+ *
+ * @param input_paths - The files to join, in order.
+ * @param output_path - The file to create.
+ * @return uint32_t - The number of samples of the new file.
+ * @throws std::runtime_error - If an input is not a 16-bit mono file at
+ * SAMPLE_RATE, the output is also an input or it would be too large.
+ */
+uint32_t concatFiles(const std::vector<std::string> &input_paths,
+                     const std::string &output_path);
+
+/**
+ * @brief Copy a range of samples to a new file, the same way as
+ * concatFiles(). The range is limited to the end of the input.
+ *
+ * @param input_path - The file to copy from.
+ * @param output_path - The file to create.
+ * @param first_sample - The first sample to copy.
+ * @param num_samples - The number of samples to copy.
+ */
+void extractSamples(const std::string &input_path,
+                    const std::string &output_path, uint32_t first_sample,
+                    uint32_t num_samples);
+
+/**
+ * @brief Split a file into pieces at sample offsets, the same way as
+ * concatFiles().
+ *
+ * @param input_path - The file to split.
+ * @param split_samples - The first sample of every piece but the first, in
+ * order.
+ * @param output_paths - The files to create, one more than split_samples.
+ */
+void splitFile(const std::string &input_path,
+               const std::vector<uint32_t> &split_samples,
+               const std::vector<std::string> &output_paths);
+
+/**
+ * @brief Shorten a file in place by truncating it and rewriting its header.
+ * Use extractSamples() to remove samples from the start. The overview
+ * sidecar of the file, if there is one, is removed.
+ *
+ * @param file_path - The file to trim.
+ * @param num_samples - The number of samples to keep.
+ * @return uint32_t - The number of samples of the file.
+ */
+uint32_t trimFile(const std::string &file_path, uint32_t num_samples);
+
+/**
+ * @brief How two files are compared.
+ */
+struct CompareOptions {
+  /**
+   * @brief The largest absolute difference of two samples that still
+   * matches.
+   */
+  uint32_t tolerance = 0;
+
+  /**
+   * @brief The number of threads to compare with, 0 for one per hardware
+   * thread. Small files are always compared on the calling thread.
+   */
+  uint32_t num_threads = 0;
+};
+
+/**
+ * @brief The result of comparing a file with a reference file. Sample
+ * indices count the interleaved samples of all channels.
+ */
+struct CompareResult {
+  /**
+   * @brief True if the sample format, channels and sample rate are equal.
+   */
+  bool formats_match = false;
+
+  uint32_t reference_samples = 0;
+  uint32_t test_samples = 0;
+
+  /**
+   * @brief The number of samples, of those both files have, that differ by
+   * more than the tolerance.
+   */
+  uint32_t num_mismatches = 0;
+
+  /**
+   * @brief The index of the first mismatch, or the length of the shorter
+   * file if only the lengths differ. -1 if the files match.
+   */
+  int64_t first_mismatch = -1;
+
+  /**
+   * @brief The largest absolute difference of two samples.
+   */
+  uint32_t max_difference = 0;
+
+  /**
+   * @brief The signal to noise ratio in dB, the reference being the signal
+   * and the difference the noise. Infinite if the samples are identical.
+   */
+  double snr_db = 0.0;
+
+  /**
+   * @brief True if the formats and lengths are equal and every sample is
+   * within the tolerance.
+   */
+  bool matches() const {
+    return formats_match && first_mismatch < 0;
+  }
+};
+
+/**
+ * @brief Compare the samples of a 16-bit file with a reference file.
+ *
+ * Both files are memory mapped and compared in blocks, eight samples at a
+ * time with SSE2 or NEON where available, large files in parallel chunks.
+ * Only the blocks with mismatches are searched again for the first one.
+ *
+ * @param reference_path - The expected (golden) file.
+ * @param test_path - The file to check.
+ * @param options - The tolerance and the number of threads.
+ * @return CompareResult - The differences.
+ * @throws std::runtime_error - If a file can not be read or is not a 16-bit
+ * WAV file.
+ */
+CompareResult compareFiles(const std::string &reference_path,
+                           const std::string &test_path,
+                           const CompareOptions &options = {});
+
+} // namespace wavgen
+
+#endif /* WAV_TOOLS_HPP_ */
@@ -0,0 +1,234 @@
+/**
+ * @file batch.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Render many WAV files concurrently from a job manifest.
+ * @date 2023-09-09
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "wav_batch.hpp"
+#include "wav_gen.hpp"
+
+namespace wavgen {
+
+namespace {
+
+std::vector<std::string> split(const std::string &text, char delimiter) {
+  std::vector<std::string> parts;
+  std::stringstream stream(text);
+  std::string part;
+  while (std::getline(stream, part, delimiter)) {
+    parts.push_back(part);
+  }
+  return parts;
+}
+
+template <typename T> T parseNumber(const std::string &text, T max) {
+  size_t used = 0;
+  const unsigned long long value = std::stoull(text, &used);
+  if (used != text.size() || value > max) {
+    throw std::invalid_argument(text);
+  }
+  return static_cast<T>(value);
+}
+
+double parseAmplitude(const std::string &text) {
+  size_t used = 0;
+  const double value = std::stod(text, &used);
+  if (used != text.size()) {
+    throw std::invalid_argument(text);
+  }
+  return value;
+}
+
+BatchSegment parseSegment(const std::string &text) {
+  const auto fields = split(text, ':');
+  BatchSegment segment;
+  if (fields.size() == 4 && fields[0] == "sine") {
+    segment.type = BatchSegment::Type::SINE_WAVE;
+    segment.frequency = parseNumber<uint16_t>(fields[1], UINT16_MAX);
+    segment.amplitude = parseAmplitude(fields[2]);
+    segment.duration_ms = parseNumber<uint16_t>(fields[3], UINT16_MAX);
+  } else if (fields.size() == 2 && fields[0] == "silence") {
+    segment.type = BatchSegment::Type::SILENCE;
+    segment.duration_ms = parseNumber<uint16_t>(fields[1], UINT16_MAX);
+  } else if (fields.size() == 3 &&
+             (fields[0] == "white" || fields[0] == "pink")) {
+    segment.type = fields[0] == "white" ? BatchSegment::Type::WHITE_NOISE
+                                        : BatchSegment::Type::PINK_NOISE;
+    segment.amplitude = parseAmplitude(fields[1]);
+    segment.duration_ms = parseNumber<uint16_t>(fields[2], UINT16_MAX);
+  } else {
+    throw std::invalid_argument(text);
+  }
+  return segment;
+}
+
+void renderJob(Generator &generator, const BatchJob &job) {
+  generator.open(job.output_path);
+  generator.reset();
+  generator.setNoiseSeed(job.noise_seed);
+
+  for (const auto &segment : job.segments) {
+    const uint32_t samples = SAMPLE_RATE_MS * segment.duration_ms;
+    switch (segment.type) {
+    case BatchSegment::Type::SINE_WAVE:
+      generator.addSineWave(segment.frequency, segment.amplitude,
+                            segment.duration_ms);
+      break;
+    case BatchSegment::Type::SILENCE:
+      generator.addSilence(samples);
+      break;
+    case BatchSegment::Type::WHITE_NOISE:
+      generator.addWhiteNoise(segment.amplitude, samples);
+      break;
+    case BatchSegment::Type::PINK_NOISE:
+      generator.addPinkNoise(segment.amplitude, samples);
+      break;
+    }
+  }
+
+  generator.done();
+}
+
+/**
+ * @brief A worker's queue of job indices. The owner takes from the back,
+ * idle workers steal from the front.
+ */
+class WorkQueue {
+public:
+  void push(size_t job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(job);
+  }
+
+  bool pop(size_t &job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (jobs_.empty()) {
+      return false;
+    }
+    job = jobs_.back();
+    jobs_.pop_back();
+    return true;
+  }
+
+  bool steal(size_t &job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (jobs_.empty()) {
+      return false;
+    }
+    job = jobs_.front();
+    jobs_.pop_front();
+    return true;
+  }
+
+private:
+  std::mutex mutex_{};
+  std::deque<size_t> jobs_{};
+};
+
+} // namespace
+
+std::vector<BatchJob> parseBatchManifest(std::istream &manifest) {
+  std::vector<BatchJob> jobs;
+  std::string line;
+  uint32_t line_number = 0;
+  while (std::getline(manifest, line)) {
+    line_number++;
+    std::stringstream fields(line);
+    std::string field;
+    if (!(fields >> field) || field[0] == '#') {
+      continue;
+    }
+
+    BatchJob job;
+    job.output_path = field;
+    try {
+      while (fields >> field) {
+        if (field.rfind("seed=", 0) == 0) {
+          job.noise_seed = parseNumber<uint64_t>(field.substr(5), UINT64_MAX);
+        } else {
+          job.segments.push_back(parseSegment(field));
+        }
+      }
+    } catch (const std::logic_error &) {
+      throw std::runtime_error("Invalid manifest entry '" + field +
+                               "' on line " + std::to_string(line_number));
+    }
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+BatchResult renderBatch(const std::vector<BatchJob> &jobs,
+                        const BatchOptions &options) {
+  uint32_t num_threads = options.num_threads;
+  if (num_threads == 0) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  num_threads = static_cast<uint32_t>(
+      std::max<size_t>(1, std::min<size_t>(num_threads, jobs.size())));
+
+  // Give each worker a contiguous range of jobs to start with.
+  std::vector<WorkQueue> queues(num_threads);
+  for (uint32_t worker = 0; worker < num_threads; worker++) {
+    const size_t first = jobs.size() * worker / num_threads;
+    const size_t last = jobs.size() * (worker + 1) / num_threads;
+    for (size_t job = first; job < last; job++) {
+      queues[worker].push(job);
+    }
+  }
+
+  BatchResult result;
+  std::mutex result_mutex;
+
+  auto work = [&](uint32_t worker) {
+    Generator generator;
+    if (options.tone_cache_bytes > 0) {
+      generator.enableToneCache(options.tone_cache_bytes);
+    }
+
+    uint32_t completed = 0;
+    size_t job = 0;
+    while (true) {
+      bool found = queues[worker].pop(job);
+      for (uint32_t i = 1; !found && i < num_threads; i++) {
+        found = queues[(worker + i) % num_threads].steal(job);
+      }
+      if (!found) {
+        break; // No jobs are added while running, so all work is done.
+      }
+
+      try {
+        renderJob(generator, jobs[job]);
+        completed++;
+      } catch (const std::exception &e) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        result.jobs_failed++;
+        result.errors.push_back(jobs[job].output_path + ": " + e.what());
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(result_mutex);
+    result.jobs_completed += completed;
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t worker = 1; worker < num_threads; worker++) {
+    threads.emplace_back(work, worker);
+  }
+  work(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return result;
+}
+
+} // namespace wavgen
@@ -0,0 +1,363 @@
+/**
+ * @file compare.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Compare the samples of two WAV files.
+ * @date 2023-11-04
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "file.hpp"
+#include "wav_gen.hpp"
+#include "wav_tools.hpp"
+
+namespace wavgen {
+
+namespace {
+
+/**
+ * @brief The number of samples compared at a time. Only blocks with a
+ * mismatch are searched for the first one.
+ */
+inline constexpr uint32_t kCompareBlockSize = 4096;
+
+/**
+ * @brief Files with fewer samples are compared on the calling thread.
+ */
+inline constexpr uint32_t kParallelSamples = 1 << 20;
+
+/**
+ * @brief A read only memory mapping of a 16-bit WAV file.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &file_path) {
+    const FileDescriptor file = openFile(file_path, O_RDONLY);
+    size_ = calculateFileSize(file);
+    layout_ = readLayout(file.get(), size_);
+    if (layout_.format.sample_format != SampleFormat::PCM_16) {
+      throw std::runtime_error(file_path + " is not a 16-bit file.");
+    }
+    mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file.get(), 0);
+    if (mapping_ == MAP_FAILED) {
+      mapping_ = nullptr;
+      throw std::runtime_error("Failed to map " + file_path + ".");
+    }
+    ::madvise(mapping_, size_, MADV_SEQUENTIAL);
+  }
+
+  ~MappedFile() {
+    if (mapping_ != nullptr) {
+      ::munmap(mapping_, size_);
+    }
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @brief The raw little-endian samples, not necessarily aligned.
+   */
+  const uint8_t *getSamples() const {
+    return static_cast<const uint8_t *>(mapping_) + layout_.data_offset;
+  }
+
+  uint32_t getNumSamples() const {
+    return layout_.data_size / sizeof(int16_t);
+  }
+
+  const WavFormat &getFormat() const {
+    return layout_.format;
+  }
+
+private:
+  void *mapping_ = nullptr;
+  uint64_t size_ = 0;
+  WavLayout layout_{};
+};
+
+/**
+ * @brief The differences within a range of samples.
+ */
+struct Differences {
+  uint32_t num_mismatches = 0;
+  int64_t first_mismatch = -1;
+  uint32_t max_difference = 0;
+  uint64_t signal = 0;
+  uint64_t noise = 0;
+};
+
+int32_t loadSample(const uint8_t *samples, uint32_t index) {
+  int16_t value;
+  std::memcpy(&value, samples + size_t{index} * sizeof(int16_t),
+              sizeof(value));
+  return value;
+}
+
+// Each 16-bit lane counts the mismatches of one in 8 samples of a block.
+static_assert(kCompareBlockSize / 8 <= UINT16_MAX,
+              "The mismatch count of a lane would overflow.");
+
+/**
+ * @brief Compare the samples of one block, without searching for the first
+ * mismatch. Eight samples at a time with SSE2 or NEON where available, the
+ * remaining samples use a scalar loop.
+ *
+ * The absolute difference of two 16-bit samples needs 16 unsigned bits, so
+ * it is compared, maximized and squared as an unsigned value. The squares
+ * are widened to 64 bits before they are summed.
+ */
+Differences compareBlock(const uint8_t *reference, const uint8_t *test,
+                         uint32_t first, uint32_t last, uint32_t tolerance) {
+  Differences result;
+  uint32_t i = first;
+  const auto tolerance_16 =
+      static_cast<uint16_t>(std::min<uint32_t>(tolerance, UINT16_MAX));
+#if defined(__SSE2__)
+  auto load = [](const uint8_t *samples, uint32_t index) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+        samples + size_t{index} * sizeof(int16_t)));
+  };
+  // Add the four unsigned 32-bit lanes of a value to two 64-bit sums.
+  const __m128i zero = _mm_setzero_si128();
+  auto widen_add = [&](__m128i sum, __m128i value) {
+    return _mm_add_epi64(sum, _mm_add_epi64(_mm_unpacklo_epi32(value, zero),
+                                            _mm_unpackhi_epi32(value, zero)));
+  };
+  // SSE2 only compares signed 16-bit values, flipping the sign bit orders
+  // unsigned values the same way.
+  const __m128i sign = _mm_set1_epi16(INT16_MIN);
+  const __m128i limit = _mm_set1_epi16(static_cast<int16_t>(tolerance_16));
+
+  __m128i within = zero;
+  __m128i max_difference = _mm_xor_si128(zero, sign);
+  __m128i signal = zero;
+  __m128i noise = zero;
+  const uint32_t num_vectors = (last - i) / 8;
+  for (; i + 8 <= last; i += 8) {
+    const __m128i expected = load(reference, i);
+    const __m128i actual = load(test, i);
+    const __m128i difference = _mm_sub_epi16(_mm_max_epi16(expected, actual),
+                                             _mm_min_epi16(expected, actual));
+
+    // The saturating subtraction is 0 where the difference is within the
+    // tolerance, the compare mask is -1 there.
+    within = _mm_sub_epi16(
+        within, _mm_cmpeq_epi16(_mm_subs_epu16(difference, limit), zero));
+    max_difference =
+        _mm_max_epi16(max_difference, _mm_xor_si128(difference, sign));
+
+    // Both squares of a sample fit in 32 bits, a sum of two only when they
+    // are signed samples (at most 2^31).
+    const __m128i low = _mm_mullo_epi16(expected, expected);
+    const __m128i high = _mm_mulhi_epi16(expected, expected);
+    signal = widen_add(signal, _mm_add_epi32(_mm_unpacklo_epi16(low, high),
+                                             _mm_unpackhi_epi16(low, high)));
+    const __m128i noise_low = _mm_mullo_epi16(difference, difference);
+    const __m128i noise_high = _mm_mulhi_epu16(difference, difference);
+    noise = widen_add(widen_add(noise, _mm_unpacklo_epi16(noise_low,
+                                                          noise_high)),
+                      _mm_unpackhi_epi16(noise_low, noise_high));
+  }
+
+  alignas(16) uint16_t within_lanes[8];
+  alignas(16) uint16_t max_lanes[8];
+  alignas(16) uint64_t signal_lanes[2];
+  alignas(16) uint64_t noise_lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(within_lanes), within);
+  _mm_store_si128(reinterpret_cast<__m128i *>(max_lanes),
+                  _mm_xor_si128(max_difference, sign));
+  _mm_store_si128(reinterpret_cast<__m128i *>(signal_lanes), signal);
+  _mm_store_si128(reinterpret_cast<__m128i *>(noise_lanes), noise);
+  uint32_t num_within = 0;
+  for (int lane = 0; lane < 8; lane++) {
+    num_within += within_lanes[lane];
+    result.max_difference =
+        std::max<uint32_t>(result.max_difference, max_lanes[lane]);
+  }
+  result.num_mismatches = num_vectors * 8 - num_within;
+  result.signal = signal_lanes[0] + signal_lanes[1];
+  result.noise = noise_lanes[0] + noise_lanes[1];
+#elif defined(__ARM_NEON)
+  // Byte loads, the samples do not have to be aligned.
+  auto load = [](const uint8_t *samples, uint32_t index) {
+    return vreinterpretq_s16_u8(
+        vld1q_u8(samples + size_t{index} * sizeof(int16_t)));
+  };
+  const uint16x8_t limit = vdupq_n_u16(tolerance_16);
+
+  uint16x8_t mismatches = vdupq_n_u16(0);
+  uint16x8_t max_difference = vdupq_n_u16(0);
+  uint64x2_t signal = vdupq_n_u64(0);
+  uint64x2_t noise = vdupq_n_u64(0);
+  for (; i + 8 <= last; i += 8) {
+    const int16x8_t expected = load(reference, i);
+    const int16x8_t actual = load(test, i);
+    // The absolute difference wraps to the right unsigned value.
+    const uint16x8_t difference =
+        vreinterpretq_u16_s16(vabdq_s16(expected, actual));
+
+    // The compare mask is all ones (-1) where the sample mismatches.
+    mismatches = vsubq_u16(mismatches, vcgtq_u16(difference, limit));
+    max_difference = vmaxq_u16(max_difference, difference);
+    signal = vpadalq_u32(signal, vreinterpretq_u32_s32(vmull_s16(
+                                     vget_low_s16(expected),
+                                     vget_low_s16(expected))));
+    signal = vpadalq_u32(signal, vreinterpretq_u32_s32(vmull_s16(
+                                     vget_high_s16(expected),
+                                     vget_high_s16(expected))));
+    noise = vpadalq_u32(noise, vmull_u16(vget_low_u16(difference),
+                                         vget_low_u16(difference)));
+    noise = vpadalq_u32(noise, vmull_u16(vget_high_u16(difference),
+                                         vget_high_u16(difference)));
+  }
+
+  uint16_t mismatch_lanes[8];
+  uint16_t max_lanes[8];
+  uint64_t signal_lanes[2];
+  uint64_t noise_lanes[2];
+  vst1q_u16(mismatch_lanes, mismatches);
+  vst1q_u16(max_lanes, max_difference);
+  vst1q_u64(signal_lanes, signal);
+  vst1q_u64(noise_lanes, noise);
+  for (int lane = 0; lane < 8; lane++) {
+    result.num_mismatches += mismatch_lanes[lane];
+    result.max_difference =
+        std::max<uint32_t>(result.max_difference, max_lanes[lane]);
+  }
+  result.signal = signal_lanes[0] + signal_lanes[1];
+  result.noise = noise_lanes[0] + noise_lanes[1];
+#endif
+  for (; i < last; i++) {
+    const int32_t expected = loadSample(reference, i);
+    const auto difference =
+        static_cast<uint32_t>(std::abs(expected - loadSample(test, i)));
+    result.num_mismatches += difference > tolerance_16;
+    result.max_difference = std::max(result.max_difference, difference);
+    result.signal += static_cast<uint64_t>(expected * expected);
+    result.noise += uint64_t{difference} * difference;
+  }
+  return result;
+}
+
+Differences compareRange(const uint8_t *reference, const uint8_t *test,
+                         uint32_t first, uint32_t last, uint32_t tolerance) {
+  Differences result;
+  for (uint32_t block = first; block < last; block += kCompareBlockSize) {
+    const uint32_t end = std::min(last, block + kCompareBlockSize);
+    const Differences differences =
+        compareBlock(reference, test, block, end, tolerance);
+
+    if (differences.num_mismatches > 0 && result.first_mismatch < 0) {
+      for (uint32_t i = block; i < end; i++) {
+        if (static_cast<uint32_t>(std::abs(loadSample(reference, i) -
+                                           loadSample(test, i))) >
+            tolerance) {
+          result.first_mismatch = i;
+          break;
+        }
+      }
+    }
+    result.num_mismatches += differences.num_mismatches;
+    result.max_difference =
+        std::max(result.max_difference, differences.max_difference);
+    result.signal += differences.signal;
+    result.noise += differences.noise;
+  }
+  return result;
+}
+
+} // namespace
+
+CompareResult compareFiles(const std::string &reference_path,
+                           const std::string &test_path,
+                           const CompareOptions &options) {
+  const MappedFile reference(reference_path);
+  const MappedFile test(test_path);
+
+  CompareResult result;
+  const WavFormat &reference_format = reference.getFormat();
+  const WavFormat &test_format = test.getFormat();
+  result.formats_match =
+      reference_format.num_channels == test_format.num_channels &&
+      reference_format.sample_rate == test_format.sample_rate;
+  result.reference_samples = reference.getNumSamples();
+  result.test_samples = test.getNumSamples();
+  const uint32_t num_samples =
+      std::min(result.reference_samples, result.test_samples);
+
+  // Each thread compares a range of whole blocks.
+  const uint32_t num_blocks =
+      (num_samples + kCompareBlockSize - 1) / kCompareBlockSize;
+  uint32_t num_threads = options.num_threads;
+  if (num_threads == 0) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  if (num_samples < kParallelSamples) {
+    num_threads = 1;
+  }
+  num_threads = std::max(1U, std::min(num_threads, num_blocks));
+
+  std::vector<Differences> parts(num_threads);
+  auto work = [&](uint32_t part) {
+    const uint64_t first_block = uint64_t{num_blocks} * part / num_threads;
+    const uint64_t last_block =
+        uint64_t{num_blocks} * (part + 1) / num_threads;
+    const auto first =
+        static_cast<uint32_t>(first_block * kCompareBlockSize);
+    const auto last = static_cast<uint32_t>(
+        std::min<uint64_t>(last_block * kCompareBlockSize, num_samples));
+    parts[part] = compareRange(reference.getSamples(), test.getSamples(),
+                               first, last, options.tolerance);
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t part = 1; part < num_threads; part++) {
+    threads.emplace_back(work, part);
+  }
+  work(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t signal = 0;
+  uint64_t noise = 0;
+  for (const auto &part : parts) {
+    result.num_mismatches += part.num_mismatches;
+    if (result.first_mismatch < 0) {
+      result.first_mismatch = part.first_mismatch;
+    }
+    result.max_difference = std::max(result.max_difference,
+                                     part.max_difference);
+    signal += part.signal;
+    noise += part.noise;
+  }
+  if (result.first_mismatch < 0 &&
+      result.reference_samples != result.test_samples) {
+    result.first_mismatch = num_samples;
+  }
+
+  if (noise == 0) {
+    result.snr_db = std::numeric_limits<double>::infinity();
+  } else {
+    result.snr_db = 10.0 * std::log10(static_cast<double>(signal) /
+                                      static_cast<double>(noise));
+  }
+  return result;
+}
+
+} // namespace wavgen
@@ -0,0 +1,135 @@
+/**
+ * @file convert.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Kernels that decode PCM samples to floating point.
+ * @date 2023-09-23
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef CONVERT_HPP_
+#define CONVERT_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include "wav_gen.hpp"
+
+namespace wavgen {
+
+/**
+ * @brief The size of one sample of one channel in bytes.
+ */
+inline constexpr uint32_t bytesPerSample(SampleFormat format) {
+  switch (format) {
+  case SampleFormat::PCM_8:
+    return 1;
+  case SampleFormat::PCM_16:
+    return 2;
+  case SampleFormat::PCM_24:
+    return 3;
+  case SampleFormat::PCM_32:
+  case SampleFormat::FLOAT_32:
+    return 4;
+  }
+  return 0;
+}
+
+/**
+ * @brief Decode one little-endian sample to the range [-1, 1]. The loads go
+ * through memcpy so unaligned input is fine and loops still vectorize.
+ */
+template <SampleFormat kFormat, typename T>
+inline T decodeSample(const uint8_t *input) {
+  if constexpr (kFormat == SampleFormat::PCM_8) {
+    return static_cast<T>(static_cast<int32_t>(input[0]) - 128) *
+           static_cast<T>(1.0 / 128.0);
+  } else if constexpr (kFormat == SampleFormat::PCM_16) {
+    int16_t value;
+    std::memcpy(&value, input, sizeof(value));
+    return static_cast<T>(value) * static_cast<T>(1.0 / 32768.0);
+  } else if constexpr (kFormat == SampleFormat::PCM_24) {
+    // Assemble in the top 24 bits so the arithmetic shift sign extends.
+    const int32_t value = static_cast<int32_t>(
+        static_cast<uint32_t>(input[0]) << 8 |
+        static_cast<uint32_t>(input[1]) << 16 |
+        static_cast<uint32_t>(input[2]) << 24);
+    return static_cast<T>(value >> 8) * static_cast<T>(1.0 / 8388608.0);
+  } else if constexpr (kFormat == SampleFormat::PCM_32) {
+    int32_t value;
+    std::memcpy(&value, input, sizeof(value));
+    return static_cast<T>(value) * static_cast<T>(1.0 / 2147483648.0);
+  } else {
+    float value;
+    std::memcpy(&value, input, sizeof(value));
+    return static_cast<T>(value);
+  }
+}
+
+/**
+ * @brief Decode interleaved frames, averaging the channels when downmixing.
+ *
+ * @param input - The raw frames.
+ * @param output - num_frames values when downmixing, otherwise num_frames *
+ * num_channels values.
+ * @param num_frames - The number of frames to decode.
+ * @param num_channels - The number of channels of each frame.
+ * @param downmix - Average the channels of each frame.
+ */
+template <SampleFormat kFormat, typename T>
+inline void decodeFrames(const uint8_t *input, T *output, uint32_t num_frames,
+                         uint16_t num_channels, bool downmix) {
+  constexpr uint32_t kBytes = bytesPerSample(kFormat);
+  if (!downmix || num_channels == 1) {
+    const uint32_t count = num_frames * num_channels;
+    for (uint32_t i = 0; i < count; i++) {
+      output[i] = decodeSample<kFormat, T>(input + i * kBytes);
+    }
+    return;
+  }
+
+  const T scale = static_cast<T>(1.0) / num_channels;
+  for (uint32_t frame = 0; frame < num_frames; frame++) {
+    const uint8_t *samples = input + frame * num_channels * kBytes;
+    T sum = 0;
+    for (uint16_t channel = 0; channel < num_channels; channel++) {
+      sum += decodeSample<kFormat, T>(samples + channel * kBytes);
+    }
+    output[frame] = sum * scale;
+  }
+}
+
+/**
+ * @brief Decode interleaved frames of a format only known at run time.
+ * @see decodeFrames()
+ */
+template <typename T>
+inline void decodeFrames(SampleFormat format, const uint8_t *input, T *output,
+                         uint32_t num_frames, uint16_t num_channels,
+                         bool downmix) {
+  switch (format) {
+  case SampleFormat::PCM_8:
+    decodeFrames<SampleFormat::PCM_8>(input, output, num_frames, num_channels,
+                                      downmix);
+    break;
+  case SampleFormat::PCM_16:
+    decodeFrames<SampleFormat::PCM_16>(input, output, num_frames,
+                                       num_channels, downmix);
+    break;
+  case SampleFormat::PCM_24:
+    decodeFrames<SampleFormat::PCM_24>(input, output, num_frames,
+                                       num_channels, downmix);
+    break;
+  case SampleFormat::PCM_32:
+    decodeFrames<SampleFormat::PCM_32>(input, output, num_frames,
+                                       num_channels, downmix);
+    break;
+  case SampleFormat::FLOAT_32:
+    decodeFrames<SampleFormat::FLOAT_32>(input, output, num_frames,
+                                         num_channels, downmix);
+    break;
+  }
+}
+
+} // namespace wavgen
+
+#endif /* CONVERT_HPP_ */
@@ -0,0 +1,227 @@
+/**
+ * @file edit.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Concatenate, split and trim WAV files without decoding them.
+ * @date 2023-09-30
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+#include "file.hpp"
+#include "wav_gen.hpp"
+#include "wav_overview.hpp"
+#include "wav_tools.hpp"
+
+namespace wavgen {
+
+namespace {
+
+/**
+ * @brief An open input file and the location of its samples.
+ */
+struct Source {
+  FileDescriptor file{};
+  uint64_t data_offset = 0;
+  uint32_t num_samples = 0;
+};
+
+Source openSource(const std::string &file_path) {
+  Source source;
+  source.file = openFile(file_path, O_RDONLY);
+  const WavLayout layout =
+      readLayout(source.file.get(), calculateFileSize(source.file));
+  if (layout.format.sample_format != SampleFormat::PCM_16 ||
+      layout.format.num_channels != 1 ||
+      layout.format.sample_rate != SAMPLE_RATE) {
+    throw std::runtime_error(file_path + " is not a 16-bit mono file at " +
+                             std::to_string(SAMPLE_RATE) + " Hz.");
+  }
+  source.data_offset = layout.data_offset;
+  source.num_samples = layout.data_size / sizeof(int16_t);
+  return source;
+}
+
+/**
+ * @brief Check if two open files are the same file, through any path.
+ */
+bool isSameFile(const FileDescriptor &a, const FileDescriptor &b) {
+  struct stat a_stat {};
+  struct stat b_stat {};
+  return ::fstat(a.get(), &a_stat) == 0 && ::fstat(b.get(), &b_stat) == 0 &&
+         a_stat.st_dev == b_stat.st_dev && a_stat.st_ino == b_stat.st_ino;
+}
+
+/**
+ * @brief Create an output file with its final header. The output is only
+ * truncated once it is known not to be one of the sources, which would
+ * otherwise be destroyed before it is copied.
+ */
+FileDescriptor createOutput(const std::string &file_path,
+                            uint64_t num_samples, const Source *sources,
+                            size_t num_sources) {
+  if (HEADER_SIZE + num_samples * sizeof(int16_t) > UINT32_MAX) {
+    throw std::runtime_error("The output would be larger than 4 GiB.");
+  }
+  FileDescriptor file = openFile(file_path, O_WRONLY | O_CREAT);
+  for (size_t i = 0; i < num_sources; i++) {
+    if (isSameFile(file, sources[i].file)) {
+      throw std::runtime_error(file_path + " is also an input.");
+    }
+  }
+  if (::ftruncate(file.get(), 0) != 0) {
+    throw std::runtime_error("Failed to truncate " + file_path + ".");
+  }
+  const auto header = packHeader(
+      makeHeader(static_cast<uint32_t>(num_samples * sizeof(int16_t))));
+  writeAt(file, header.data(), header.size(), 0);
+  return file;
+}
+
+/**
+ * @brief Copy bytes between files inside the kernel. copy_file_range() lets
+ * the filesystem share extents (reflink) or copy server side where it can,
+ * sendfile() still avoids user space copies across filesystems, and a pread
+ * and pwrite loop is the last resort.
+ */
+void copyRange(const FileDescriptor &input, uint64_t input_offset,
+               const FileDescriptor &output, uint64_t output_offset,
+               uint64_t num_bytes) {
+  while (num_bytes > 0) {
+    loff_t in = static_cast<loff_t>(input_offset);
+    loff_t out = static_cast<loff_t>(output_offset);
+    const ssize_t result = ::copy_file_range(input.get(), &in, output.get(),
+                                             &out, num_bytes, 0);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      break;
+    }
+    input_offset += static_cast<uint64_t>(result);
+    output_offset += static_cast<uint64_t>(result);
+    num_bytes -= static_cast<uint64_t>(result);
+  }
+
+  if (num_bytes > 0 &&
+      ::lseek(output.get(), static_cast<off_t>(output_offset), SEEK_SET) >= 0) {
+    while (num_bytes > 0) {
+      off_t in = static_cast<off_t>(input_offset);
+      const ssize_t result =
+          ::sendfile(output.get(), input.get(), &in, num_bytes);
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result <= 0) {
+        break;
+      }
+      input_offset += static_cast<uint64_t>(result);
+      output_offset += static_cast<uint64_t>(result);
+      num_bytes -= static_cast<uint64_t>(result);
+    }
+  }
+
+  std::vector<char> buffer;
+  while (num_bytes > 0) {
+    buffer.resize(std::min<uint64_t>(num_bytes, 1 << 20));
+    const size_t count = readAt(input, buffer.data(), buffer.size(),
+                                input_offset);
+    if (count == 0) {
+      throw std::runtime_error("Failed to copy samples, file is too short.");
+    }
+    writeAt(output, buffer.data(), count, output_offset);
+    input_offset += count;
+    output_offset += count;
+    num_bytes -= count;
+  }
+}
+
+/**
+ * @brief Copy a range of samples of a source to a new file.
+ */
+void writeRange(const Source &source, const std::string &output_path,
+                uint32_t first_sample, uint32_t num_samples) {
+  first_sample = std::min(first_sample, source.num_samples);
+  num_samples = std::min(num_samples, source.num_samples - first_sample);
+
+  const FileDescriptor output =
+      createOutput(output_path, num_samples, &source, 1);
+  copyRange(source.file,
+            source.data_offset + uint64_t{first_sample} * sizeof(int16_t),
+            output, HEADER_SIZE, uint64_t{num_samples} * sizeof(int16_t));
+}
+
+} // namespace
+
+uint32_t concatFiles(const std::vector<std::string> &input_paths,
+                     const std::string &output_path) {
+  std::vector<Source> sources;
+  uint64_t total = 0;
+  for (const auto &path : input_paths) {
+    sources.push_back(openSource(path));
+    total += sources.back().num_samples;
+  }
+
+  const FileDescriptor output =
+      createOutput(output_path, total, sources.data(), sources.size());
+  uint64_t position = HEADER_SIZE;
+  for (const auto &source : sources) {
+    const uint64_t num_bytes = uint64_t{source.num_samples} * sizeof(int16_t);
+    copyRange(source.file, source.data_offset, output, position, num_bytes);
+    position += num_bytes;
+  }
+  return static_cast<uint32_t>(total);
+}
+
+void extractSamples(const std::string &input_path,
+                    const std::string &output_path, uint32_t first_sample,
+                    uint32_t num_samples) {
+  writeRange(openSource(input_path), output_path, first_sample, num_samples);
+}
+
+void splitFile(const std::string &input_path,
+               const std::vector<uint32_t> &split_samples,
+               const std::vector<std::string> &output_paths) {
+  if (output_paths.size() != split_samples.size() + 1) {
+    throw std::runtime_error("Need one more output than split points.");
+  }
+  if (!std::is_sorted(split_samples.begin(), split_samples.end())) {
+    throw std::runtime_error("Split points must be in order.");
+  }
+
+  const Source source = openSource(input_path);
+  uint32_t first = 0;
+  for (size_t i = 0; i < output_paths.size(); i++) {
+    const uint32_t last = i < split_samples.size()
+                              ? std::min(split_samples[i], source.num_samples)
+                              : source.num_samples;
+    writeRange(source, output_paths[i], first, last - first);
+    first = last;
+  }
+}
+
+uint32_t trimFile(const std::string &file_path, uint32_t num_samples) {
+  const Source source = openSource(file_path);
+  num_samples = std::min(num_samples, source.num_samples);
+
+  // Only our own layout can be trimmed in place by truncating.
+  if (source.data_offset != HEADER_SIZE) {
+    throw std::runtime_error("Can not trim a file with extra chunks.");
+  }
+  Overview::removeSidecar(file_path);
+  const FileDescriptor file = openFile(file_path, O_WRONLY);
+  const uint32_t data_size = num_samples * sizeof(int16_t);
+  if (::ftruncate(file.get(), static_cast<off_t>(HEADER_SIZE + data_size)) !=
+      0) {
+    throw std::runtime_error("Failed to truncate file.");
+  }
+  const auto header = packHeader(makeHeader(data_size));
+  writeAt(file, header.data(), header.size(), 0);
+  return num_samples;
+}
+
+} // namespace wavgen
@@ -0,0 +1,27 @@
+/**
+ * @file error.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Error reporting that also builds without exceptions.
+ * @date 2023-10-21
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef ERROR_HPP_
+#define ERROR_HPP_
+
+#include <cstdlib>
+#include <stdexcept>
+
+/**
+ * @brief Throw an exception. When built with WAVGEN_NO_EXCEPTIONS this
+ * aborts instead, it is only used off the sample path for errors that are
+ * programming mistakes (invalid filter designs, file helpers of the tools).
+ * The Writer and Generator report errors through Status codes instead.
+ */
+#ifdef WAVGEN_NO_EXCEPTIONS
+#define WAVGEN_THROW(exception) std::abort()
+#else
+#define WAVGEN_THROW(exception) throw exception
+#endif
+
+#endif /* ERROR_HPP_ */
@@ -0,0 +1,118 @@
+/**
+ * @file fft.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief A small fixed size radix-2 FFT used by the filters.
+ * @date 2023-08-05
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef FFT_HPP_
+#define FFT_HPP_
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "error.hpp"
+
+namespace wavgen {
+
+/**
+ * @brief An in-place, iterative radix-2 FFT with precomputed twiddles and
+ * bit reversal table. The size is fixed at construction so the transform
+ * itself never allocates.
+ */
+class Fft {
+public:
+  using Complex = std::complex<float>;
+
+  /**
+   * @param size - The transform size, must be a power of two.
+   */
+  explicit Fft(size_t size)
+      : size_(size), twiddles_(size / 2), reversed_(size) {
+    if (size < 2 || (size & (size - 1)) != 0) {
+      WAVGEN_THROW(std::runtime_error("FFT size must be a power of two."));
+    }
+
+    const double pi = std::atan(1) * 4;
+    for (size_t i = 0; i < size / 2; i++) {
+      const double angle = -2.0 * pi * static_cast<double>(i) / size;
+      twiddles_[i] = Complex(static_cast<float>(std::cos(angle)),
+                             static_cast<float>(std::sin(angle)));
+    }
+
+    size_t bits = 0;
+    while ((size_t{1} << bits) < size) {
+      bits++;
+    }
+    for (size_t i = 0; i < size; i++) {
+      size_t reversed = 0;
+      for (size_t b = 0; b < bits; b++) {
+        reversed |= ((i >> b) & 1) << (bits - 1 - b);
+      }
+      reversed_[i] = reversed;
+    }
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  /**
+   * @brief Forward transform, in place.
+   */
+  void forward(Complex *data) const {
+    transform(data, false);
+  }
+
+  /**
+   * @brief Inverse transform, in place. The result is scaled by 1/size.
+   */
+  void inverse(Complex *data) const {
+    transform(data, true);
+    const float scale = 1.0f / static_cast<float>(size_);
+    for (size_t i = 0; i < size_; i++) {
+      data[i] *= scale;
+    }
+  }
+
+private:
+  void transform(Complex *data, bool inverse) const {
+    for (size_t i = 0; i < size_; i++) {
+      if (i < reversed_[i]) {
+        std::swap(data[i], data[reversed_[i]]);
+      }
+    }
+
+    for (size_t length = 2; length <= size_; length <<= 1) {
+      const size_t half = length / 2;
+      const size_t stride = size_ / length;
+      for (size_t start = 0; start < size_; start += length) {
+        for (size_t k = 0; k < half; k++) {
+          Complex twiddle = twiddles_[k * stride];
+          if (inverse) {
+            twiddle = std::conj(twiddle);
+          }
+          // Written out to avoid the NaN handling of std::complex multiply.
+          const Complex in = data[start + k + half];
+          const Complex odd(
+              in.real() * twiddle.real() - in.imag() * twiddle.imag(),
+              in.real() * twiddle.imag() + in.imag() * twiddle.real());
+          data[start + k + half] = data[start + k] - odd;
+          data[start + k] += odd;
+        }
+      }
+    }
+  }
+
+  size_t size_;
+  std::vector<Complex> twiddles_;
+  std::vector<size_t> reversed_;
+};
+
+} // namespace wavgen
+
+#endif /* FFT_HPP_ */
@@ -9,17 +9,143 @@
 #ifndef FILE_HPP_
 #define FILE_HPP_
 
+#include <array>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "error.hpp"
 #include "wav_gen.hpp"
 
 namespace wavgen {
 
+inline constexpr uint32_t kWavHeaderSize = 44;
+
+// RIFF****WAVEfmt
+inline constexpr std::string_view kRiffChunkDescriptor = "RIFF";
+inline constexpr std::string_view kWavFormat = "WAVE";
+inline constexpr std::string_view kFormatChunkDescriptor = "fmt ";
+
+inline constexpr uint32_t kFormatChunkSize = 16;
+inline constexpr uint32_t kFormatCode = 1;
+inline constexpr uint32_t kNumChannels = 1;
+
+inline constexpr uint32_t kByteRate =
+    (SAMPLE_RATE * SAMPLE_RESOLUTION * kNumChannels) / 8;
+inline constexpr uint32_t kBlockAlign = (SAMPLE_RESOLUTION * kNumChannels) / 8;
+inline constexpr std::string_view kDataChunkDescriptor = "data";
+
 struct WavHeader {
-  uint32_t file_size;
-  uint32_t data_chunk_size;
+  uint32_t file_size = HEADER_SIZE - 8;
+  uint32_t data_chunk_size = 0;
+  uint16_t num_channels = kNumChannels;
+};
+
+/**
+ * @brief Store a little-endian value in a header.
+ */
+constexpr void putHeaderField(std::array<char, HEADER_SIZE> &bytes,
+                              size_t offset, uint32_t value, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    bytes[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+/**
+ * @brief The header of an empty file, built at compile time.
+ */
+constexpr std::array<char, HEADER_SIZE> makeHeaderTemplate() {
+  std::array<char, HEADER_SIZE> bytes{};
+  auto putString = [&bytes](size_t offset, std::string_view value) {
+    for (size_t i = 0; i < value.size(); i++) {
+      bytes[offset + i] = value[i];
+    }
+  };
+
+  putString(0, kRiffChunkDescriptor);
+  putHeaderField(bytes, 4, HEADER_SIZE - 8, 4);
+  putString(8, kWavFormat);
+  putString(12, kFormatChunkDescriptor);
+  putHeaderField(bytes, 16, kFormatChunkSize, 4);
+  putHeaderField(bytes, 20, kFormatCode, 2);
+  putHeaderField(bytes, 22, kNumChannels, 2);
+  putHeaderField(bytes, 24, SAMPLE_RATE, 4);
+  putHeaderField(bytes, 28, kByteRate, 4);
+  putHeaderField(bytes, 32, kBlockAlign, 2);
+  putHeaderField(bytes, 34, SAMPLE_RESOLUTION, 2);
+  putString(36, kDataChunkDescriptor);
+  putHeaderField(bytes, 40, 0, 4);
+  return bytes;
+}
+
+inline constexpr std::array<char, HEADER_SIZE> kHeaderTemplate =
+    makeHeaderTemplate();
+
+/**
+ * @brief Serialize a header to its 44 byte on disk form. Only the size and
+ * channel fields are filled in at run time, nothing is allocated.
+ *
+ * @param header - The header to serialize.
+ * @return std::array<char, HEADER_SIZE> - The header bytes.
+ */
+constexpr std::array<char, HEADER_SIZE> packHeader(const WavHeader &header) {
+  std::array<char, HEADER_SIZE> bytes = kHeaderTemplate;
+  putHeaderField(bytes, 4, header.file_size, 4);
+  putHeaderField(bytes, 40, header.data_chunk_size, 4);
+  if (header.num_channels != kNumChannels) {
+    const uint32_t block_align = kBlockAlign * header.num_channels;
+    putHeaderField(bytes, 22, header.num_channels, 2);
+    putHeaderField(bytes, 28, SAMPLE_RATE * block_align, 4);
+    putHeaderField(bytes, 32, block_align, 2);
+  }
+  return bytes;
+}
+
+/**
+ * @brief Build the header for a data chunk of a given size.
+ *
+ * @param data_chunk_size - The size of the data chunk in bytes.
+ * @param num_channels - The number of interleaved channels.
+ * @return WavHeader - The header.
+ */
+constexpr WavHeader makeHeader(uint32_t data_chunk_size,
+                               uint16_t num_channels = kNumChannels) {
+  WavHeader header;
+  header.data_chunk_size = data_chunk_size;
+  header.num_channels = num_channels;
+  header.file_size = data_chunk_size + HEADER_SIZE - 8;
+  return header;
+}
+
+/**
+ * @brief The format and the location of the samples of any PCM WAV file.
+ */
+struct WavLayout {
+  WavFormat format{};
+  uint16_t block_align = 0;
+  uint64_t data_offset = 0;
+  uint32_t data_size = 0;
 };
 
+/**
+ * @brief Read the chunks of a WAV file to find its format and data chunk.
+ * Unknown chunks are skipped and WAVE_FORMAT_EXTENSIBLE is understood.
+ *
+ * @param fd - The file to read.
+ * @param file_size - The size of the file in bytes.
+ * @param check_data_size - Reject a data chunk that is larger than the
+ * file. False for files whose sizes are expected to be stale.
+ * @return WavLayout - The format and the location of the data chunk.
+ * @throws std::runtime_error - If the file is not a supported WAV file.
+ */
+WavLayout readLayout(int fd, uint64_t file_size, bool check_data_size = true);
+
 std::ofstream &operator<<(std::ofstream &out_file, const WavHeader &header);
 std::ifstream &operator>>(std::ifstream &in_file, WavHeader &header);
 
@@ -75,7 +201,7 @@ inline void writeBytes(std::ofstream &wav_file, uint32_t data) {
  */
 template <typename stream_t> inline void validateFileOpen(stream_t &wav_file) {
   if (!wav_file.is_open()) {
-    throw std::runtime_error("File is not open");
+    WAVGEN_THROW(std::runtime_error("File is not open"));
   }
 }
 
@@ -111,6 +237,170 @@ template <typename stream_t> inline uint32_t calculateDuration(stream_t &file) {
   return num_samples / kSamplesPerMillisecond;
 }
 
+/**
+ * @brief Owns a POSIX file descriptor and closes it on destruction.
+ */
+class FileDescriptor {
+public:
+  explicit FileDescriptor(int fd = -1) : fd_(fd) {
+  }
+
+  ~FileDescriptor() {
+    close();
+  }
+
+  FileDescriptor(const FileDescriptor &) = delete;
+  FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+  FileDescriptor(FileDescriptor &&other) noexcept : fd_(other.fd_) {
+    other.fd_ = -1;
+  }
+
+  FileDescriptor &operator=(FileDescriptor &&other) noexcept {
+    if (this != &other) {
+      close();
+      fd_ = other.fd_;
+      other.fd_ = -1;
+    }
+    return *this;
+  }
+
+  int get() const {
+    return fd_;
+  }
+
+  bool isOpen() const {
+    return fd_ >= 0;
+  }
+
+  /**
+   * @brief Give up ownership of the descriptor without closing it.
+   */
+  int release() {
+    const int fd = fd_;
+    fd_ = -1;
+    return fd;
+  }
+
+  void close() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+private:
+  int fd_;
+};
+
+/**
+ * @brief Open a file with POSIX open().
+ *
+ * @param file_path - The file to open.
+ * @param flags - The open() flags.
+ * @return FileDescriptor - The open file.
+ */
+inline FileDescriptor openFile(const std::string &file_path, int flags) {
+  const int fd = ::open(file_path.c_str(), flags | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    WAVGEN_THROW(std::runtime_error("Failed to open " + file_path + ": " +
+                                    std::strerror(errno)));
+  }
+  return FileDescriptor(fd);
+}
+
+/**
+ * @brief Get the size of an open file in bytes.
+ */
+inline uint64_t calculateFileSize(const FileDescriptor &file) {
+  const off_t size = ::lseek(file.get(), 0, SEEK_END);
+  if (size < 0) {
+    WAVGEN_THROW(std::runtime_error("Failed to get file size."));
+  }
+  return static_cast<uint64_t>(size);
+}
+
+/**
+ * @brief Read exactly num_bytes at an offset, retrying short reads.
+ * @return size_t - The number of bytes read, less than num_bytes only at the
+ * end of the file.
+ */
+inline size_t readAt(int fd, void *data, size_t num_bytes, uint64_t offset) {
+  size_t total = 0;
+  while (total < num_bytes) {
+    const ssize_t result =
+        ::pread(fd, static_cast<char *>(data) + total,
+                num_bytes - total, static_cast<off_t>(offset + total));
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result < 0) {
+      WAVGEN_THROW(std::runtime_error("Failed to read file."));
+    }
+    if (result == 0) {
+      break;
+    }
+    total += static_cast<size_t>(result);
+  }
+  return total;
+}
+
+/**
+ * @brief Write exactly num_bytes at an offset, retrying short writes.
+ * @return bool - False if the write failed, errno is set.
+ */
+inline bool tryWriteAt(int fd, const void *data, size_t num_bytes,
+                       uint64_t offset) {
+  size_t total = 0;
+  while (total < num_bytes) {
+    const ssize_t result =
+        ::pwrite(fd, static_cast<const char *>(data) + total,
+                 num_bytes - total, static_cast<off_t>(offset + total));
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result < 0) {
+      return false;
+    }
+    total += static_cast<size_t>(result);
+  }
+  return true;
+}
+
+/**
+ * @brief Write exactly num_bytes at an offset, retrying short writes.
+ */
+inline void writeAt(int fd, const void *data, size_t num_bytes,
+                    uint64_t offset) {
+  if (!tryWriteAt(fd, data, num_bytes, offset)) {
+    WAVGEN_THROW(std::runtime_error("Failed to write file."));
+  }
+}
+
+inline size_t readAt(const FileDescriptor &file, void *data, size_t num_bytes,
+                     uint64_t offset) {
+  return readAt(file.get(), data, num_bytes, offset);
+}
+
+inline void writeAt(const FileDescriptor &file, const void *data,
+                    size_t num_bytes, uint64_t offset) {
+  writeAt(file.get(), data, num_bytes, offset);
+}
+
+/**
+ * @brief Read and validate the header of a WAV file.
+ *
+ * @param file_path - The file to read the header of.
+ * @return WavHeader - The header.
+ */
+inline WavHeader readHeader(const std::string &file_path) {
+  std::ifstream in_file(file_path, std::ios::binary);
+  validateFileOpen(in_file);
+  WavHeader header;
+  in_file >> header;
+  return header;
+}
+
 } // namespace wavgen
 
 #endif /* FILE_HPP_ */
\ No newline at end of file
@@ -0,0 +1,339 @@
+/**
+ * @file filter.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Block based IIR and FIR filters.
+ * @date 2023-08-05
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "error.hpp"
+#include "fft.hpp"
+#include "wav_filter.hpp"
+#include "wav_gen.hpp"
+
+namespace wavgen {
+
+namespace {
+
+const double kPi = std::atan(1) * 4;
+
+/**
+ * @brief The number of samples converted at a time when filtering 16-bit
+ * samples, and the number of samples run through the direct FIR at a time.
+ */
+inline constexpr size_t kChunkSize = 256;
+
+inline constexpr float kInt16Scale = 32768.0f;
+
+double sinc(double x) {
+  if (std::fabs(x) < 1e-12) {
+    return 1.0;
+  }
+  return std::sin(kPi * x) / (kPi * x);
+}
+
+double hamming(size_t n, size_t num_taps) {
+  if (num_taps < 2) {
+    return 1.0;
+  }
+  return 0.54 - 0.46 * std::cos(2.0 * kPi * n / (num_taps - 1));
+}
+
+BiquadFilter::Coefficients normalize(double b0, double b1, double b2,
+                                     double a0, double a1, double a2) {
+  BiquadFilter::Coefficients coefficients;
+  coefficients.b0 = b0 / a0;
+  coefficients.b1 = b1 / a0;
+  coefficients.b2 = b2 / a0;
+  coefficients.a1 = a1 / a0;
+  coefficients.a2 = a2 / a0;
+  return coefficients;
+}
+
+} // namespace
+
+void Filter::process(int16_t *samples, size_t num_samples) {
+  std::array<float, kChunkSize> chunk;
+  while (num_samples > 0) {
+    const size_t count = std::min(num_samples, kChunkSize);
+    for (size_t i = 0; i < count; i++) {
+      chunk[i] = samples[i] * (1.0f / kInt16Scale);
+    }
+
+    process(chunk.data(), count);
+
+    // Round half away from zero, then clamp. Rounding after the clamp, or
+    // with lrint(), keeps GCC from vectorizing the loop.
+    for (size_t i = 0; i < count; i++) {
+      float value = chunk[i] * kInt16Scale;
+      value += value < 0.0f ? -0.5f : 0.5f;
+      samples[i] =
+          static_cast<int16_t>(std::clamp(value, -32768.0f, 32767.0f));
+    }
+    samples += count;
+    num_samples -= count;
+  }
+}
+
+BiquadFilter::Coefficients BiquadFilter::lowPass(double cutoff_hz, double q) {
+  const double w0 = 2.0 * kPi * cutoff_hz / SAMPLE_RATE;
+  const double alpha = std::sin(w0) / (2.0 * q);
+  const double cos_w0 = std::cos(w0);
+  return normalize((1.0 - cos_w0) / 2.0, 1.0 - cos_w0, (1.0 - cos_w0) / 2.0,
+                   1.0 + alpha, -2.0 * cos_w0, 1.0 - alpha);
+}
+
+BiquadFilter::Coefficients BiquadFilter::highPass(double cutoff_hz, double q) {
+  const double w0 = 2.0 * kPi * cutoff_hz / SAMPLE_RATE;
+  const double alpha = std::sin(w0) / (2.0 * q);
+  const double cos_w0 = std::cos(w0);
+  return normalize((1.0 + cos_w0) / 2.0, -(1.0 + cos_w0), (1.0 + cos_w0) / 2.0,
+                   1.0 + alpha, -2.0 * cos_w0, 1.0 - alpha);
+}
+
+BiquadFilter::Coefficients BiquadFilter::bandPass(double center_hz, double q) {
+  const double w0 = 2.0 * kPi * center_hz / SAMPLE_RATE;
+  const double alpha = std::sin(w0) / (2.0 * q);
+  const double cos_w0 = std::cos(w0);
+  return normalize(alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * cos_w0,
+                   1.0 - alpha);
+}
+
+BiquadFilter::BiquadFilter(const std::vector<Coefficients> &sections) {
+  for (const auto &coefficients : sections) {
+    addSection(coefficients);
+  }
+}
+
+void BiquadFilter::addSection(const Coefficients &coefficients) {
+  Section section;
+  section.coefficients = coefficients;
+  sections_.push_back(section);
+}
+
+void BiquadFilter::process(float *samples, size_t num_samples) {
+  // The recursion is serial in time, so the block is run through one section
+  // at a time. The block stays in cache and each section keeps its
+  // coefficients and state in registers for the whole pass.
+  for (auto &section : sections_) {
+    const double b0 = section.coefficients.b0;
+    const double b1 = section.coefficients.b1;
+    const double b2 = section.coefficients.b2;
+    const double a1 = section.coefficients.a1;
+    const double a2 = section.coefficients.a2;
+    double z1 = section.z1;
+    double z2 = section.z2;
+
+    for (size_t i = 0; i < num_samples; i++) {
+      const double x = samples[i];
+      const double y = b0 * x + z1;
+      z1 = b1 * x - a1 * y + z2;
+      z2 = b2 * x - a2 * y;
+      samples[i] = static_cast<float>(y);
+    }
+
+    section.z1 = z1;
+    section.z2 = z2;
+  }
+}
+
+void BiquadFilter::reset() {
+  for (auto &section : sections_) {
+    section.z1 = 0.0;
+    section.z2 = 0.0;
+  }
+}
+
+std::vector<float> FirFilter::designLowPass(double cutoff_hz,
+                                            size_t num_taps) {
+  const double cutoff = cutoff_hz / SAMPLE_RATE;
+  const double center = (num_taps - 1) / 2.0;
+
+  std::vector<float> taps(num_taps);
+  double sum = 0.0;
+  for (size_t i = 0; i < num_taps; i++) {
+    const double tap =
+        2.0 * cutoff * sinc(2.0 * cutoff * (i - center)) * hamming(i, num_taps);
+    taps[i] = static_cast<float>(tap);
+    sum += tap;
+  }
+
+  // Unity gain at DC.
+  for (auto &tap : taps) {
+    tap = static_cast<float>(tap / sum);
+  }
+  return taps;
+}
+
+std::vector<float> FirFilter::designBandPass(double low_hz, double high_hz,
+                                             size_t num_taps) {
+  const double low = low_hz / SAMPLE_RATE;
+  const double high = high_hz / SAMPLE_RATE;
+  const double center = (num_taps - 1) / 2.0;
+
+  std::vector<float> taps(num_taps);
+  for (size_t i = 0; i < num_taps; i++) {
+    const double offset = i - center;
+    const double ideal = 2.0 * high * sinc(2.0 * high * offset) -
+                         2.0 * low * sinc(2.0 * low * offset);
+    taps[i] = static_cast<float>(ideal * hamming(i, num_taps));
+  }
+  return taps;
+}
+
+FirFilter::FirFilter(const std::vector<float> &taps)
+    : num_taps_(taps.size()), fft_(nullptr) {
+  if (taps.empty()) {
+    WAVGEN_THROW(std::runtime_error("A FIR filter needs at least one tap."));
+  }
+
+  const size_t num_head_taps = std::min(num_taps_, kPartitionSize);
+  head_taps_.assign(taps.rbegin() + (num_taps_ - num_head_taps), taps.rend());
+  history_.assign(num_head_taps - 1 + kChunkSize, 0.0f);
+
+  if (num_taps_ <= kPartitionSize) {
+    return;
+  }
+
+  // Split the remaining taps into partitions of kPartitionSize and store the
+  // spectrum of each, zero padded to twice the partition size.
+  constexpr size_t kFftSize = kPartitionSize * 2;
+  fft_ = std::make_unique<Fft>(kFftSize);
+
+  const size_t num_tail_taps = num_taps_ - kPartitionSize;
+  const size_t num_partitions =
+      (num_tail_taps + kPartitionSize - 1) / kPartitionSize;
+  for (size_t p = 0; p < num_partitions; p++) {
+    std::vector<Complex> partition(kFftSize, Complex(0.0f, 0.0f));
+    for (size_t k = 0; k < kPartitionSize; k++) {
+      const size_t tap = kPartitionSize * (p + 1) + k;
+      if (tap < num_taps_) {
+        partition[k] = Complex(taps[tap], 0.0f);
+      }
+    }
+    fft_->forward(partition.data());
+    partitions_.push_back(std::move(partition));
+  }
+
+  spectra_.assign(num_partitions,
+                  std::vector<Complex>(kFftSize, Complex(0.0f, 0.0f)));
+  previous_block_.assign(kPartitionSize, 0.0f);
+  current_block_.assign(kPartitionSize, 0.0f);
+  tail_output_.assign(kPartitionSize, 0.0f);
+  scratch_.assign(kFftSize, Complex(0.0f, 0.0f));
+}
+
+FirFilter::~FirFilter() = default;
+
+void FirFilter::process(float *samples, size_t num_samples) {
+  if (!isPartitioned()) {
+    processDirect(samples, num_samples);
+    return;
+  }
+
+  while (num_samples > 0) {
+    if (block_position_ == 0) {
+      computeTailBlock();
+    }
+
+    const size_t count =
+        std::min(num_samples, kPartitionSize - block_position_);
+    std::memcpy(current_block_.data() + block_position_, samples,
+                count * sizeof(float));
+
+    processDirect(samples, count);
+    const float *tail = tail_output_.data() + block_position_;
+    for (size_t i = 0; i < count; i++) {
+      samples[i] += tail[i];
+    }
+
+    block_position_ += count;
+    if (block_position_ == kPartitionSize) {
+      pushInputBlock();
+      block_position_ = 0;
+    }
+    samples += count;
+    num_samples -= count;
+  }
+}
+
+void FirFilter::reset() {
+  std::fill(history_.begin(), history_.end(), 0.0f);
+  for (auto &spectrum : spectra_) {
+    std::fill(spectrum.begin(), spectrum.end(), Complex(0.0f, 0.0f));
+  }
+  std::fill(previous_block_.begin(), previous_block_.end(), 0.0f);
+  std::fill(current_block_.begin(), current_block_.end(), 0.0f);
+  std::fill(tail_output_.begin(), tail_output_.end(), 0.0f);
+  block_position_ = 0;
+}
+
+void FirFilter::processDirect(float *samples, size_t num_samples) {
+  const size_t num_head_taps = head_taps_.size();
+  const size_t overlap = num_head_taps - 1;
+  const float *taps = head_taps_.data();
+  float *history = history_.data();
+
+  while (num_samples > 0) {
+    const size_t count = std::min(num_samples, kChunkSize);
+    std::memcpy(history + overlap, samples, count * sizeof(float));
+
+    // Each output is a contiguous dot product, which the compiler vectorizes.
+    for (size_t i = 0; i < count; i++) {
+      const float *window = history + i;
+      float sum = 0.0f;
+      for (size_t k = 0; k < num_head_taps; k++) {
+        sum += taps[k] * window[k];
+      }
+      samples[i] = sum;
+    }
+
+    std::memmove(history, history + count, overlap * sizeof(float));
+    samples += count;
+    num_samples -= count;
+  }
+}
+
+void FirFilter::computeTailBlock() {
+  // The tail contribution to block j only depends on the input spectra of
+  // blocks j - 1 and older, so it can be computed before block j arrives.
+  const size_t num_partitions = partitions_.size();
+  const size_t fft_size = fft_->size();
+  std::fill(scratch_.begin(), scratch_.end(), Complex(0.0f, 0.0f));
+
+  for (size_t p = 0; p < num_partitions; p++) {
+    const size_t index = (newest_spectrum_ + num_partitions - p) %
+                         num_partitions;
+    const Complex *x = spectra_[index].data();
+    const Complex *h = partitions_[p].data();
+    for (size_t k = 0; k < fft_size; k++) {
+      scratch_[k] += Complex(
+          x[k].real() * h[k].real() - x[k].imag() * h[k].imag(),
+          x[k].real() * h[k].imag() + x[k].imag() * h[k].real());
+    }
+  }
+
+  fft_->inverse(scratch_.data());
+  for (size_t i = 0; i < kPartitionSize; i++) {
+    tail_output_[i] = scratch_[kPartitionSize + i].real();
+  }
+}
+
+void FirFilter::pushInputBlock() {
+  newest_spectrum_ = (newest_spectrum_ + 1) % partitions_.size();
+  auto &spectrum = spectra_[newest_spectrum_];
+  for (size_t i = 0; i < kPartitionSize; i++) {
+    spectrum[i] = Complex(previous_block_[i], 0.0f);
+    spectrum[kPartitionSize + i] = Complex(current_block_[i], 0.0f);
+  }
+  fft_->forward(spectrum.data());
+  previous_block_.swap(current_block_);
+}
+
+} // namespace wavgen
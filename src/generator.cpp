@@ -7,8 +7,15 @@
  * @copyright Copyright (c) 2022
  */
 
+#include <algorithm>
+#include <array>
+#include <cctype>
 #include <cmath>
+#include <stdexcept>
+#include <string_view>
 
+#include "oscillator.hpp"
+#include "tone_cache.hpp"
 #include "wav_gen.hpp"
 
 inline constexpr double pi2() {
@@ -17,34 +24,36 @@ inline constexpr double pi2() {
 
 namespace wavgen {
 
-void Generator::addSineWave(uint16_t frequency, double amplitude,
-                            uint16_t duration_ms) {
-
-  /**
-   * @brief The delta angle between samples.
-   */
-  const double d_wave = pi2() * frequency / SAMPLE_RATE;
+namespace {
 
+/**
+ * @brief Render part of a sine wave that fades in over the first and out over
+ * the last SINE_WAVE_SAMPLES_TO_FILTER samples.
+ *
+ * @param output - The buffer to render into.
+ * @param first - The index of the first sample to render within the wave.
+ * @param count - The number of samples to render.
+ * @param total_samples - The total number of samples of the wave.
+ * @param d_wave - The delta angle between samples.
+ * @param amplitude - The amplitude of the sine wave (0.0 - 1.0)
+ * @param angle - The angle of the wave, updated.
+ * @param filter - The fade filter state, starts at 0.0 and is updated.
+ */
+void renderFadedSine(int16_t *output, uint32_t first, uint32_t count,
+                     uint32_t total_samples, double d_wave, double amplitude,
+                     double &angle, double &filter) {
   /**
    * @brief The delta of the filter.
    */
   const double d_filter = 1.0f / SINE_WAVE_SAMPLES_TO_FILTER;
-  const uint32_t total_samples = SAMPLE_RATE_MS * duration_ms;
 
-  /**
-   * @brief Filter to reduce the amplitude of the wave in the first and last
-   * SINE_WAVE_SAMPLES_TO_FILTER samples.
-   */
-  double filter = 0.0f;
-
-  for (uint32_t i = 0; i < total_samples; i++) { // For each sample
-    wave_angle_ += d_wave;
-    int16_t sample = static_cast<int16_t>(
-        (filter * amplitude * sin(wave_angle_)) * MAX_SAMPLE_AMPLITUDE);
-    addSample(sample);
+  for (uint32_t i = first; i < first + count; i++) { // For each sample
+    angle += d_wave;
+    output[i - first] = static_cast<int16_t>(
+        (filter * amplitude * sin(angle)) * MAX_SAMPLE_AMPLITUDE);
 
-    if (wave_angle_ > pi2()) {
-      wave_angle_ -= pi2();
+    if (angle > pi2()) {
+      angle -= pi2();
     }
 
     // Adjust the filter
@@ -58,20 +67,293 @@ void Generator::addSineWave(uint16_t frequency, double amplitude,
   }
 }
 
+/**
+ * @brief Add a segment to a generator, through the tone cache if it is
+ * enabled.
+ *
+ * @param generator - The generator to add the samples to.
+ * @param cache - The tone cache, or nullptr.
+ * @param key - The cache key, the phase index is filled in here.
+ * @param angle - The oscillator angle, rounded to a phase step when caching.
+ * @param render - Renders (output, first, count) of the segment.
+ */
+template <typename RenderFunction>
+void addSegment(Generator &generator, ToneCache *cache, ToneCache::Key key,
+                double &angle, RenderFunction render) {
+  const uint32_t total_samples = key.samples;
+
+  // Segments that could never be cached are streamed in blocks instead of
+  // being rendered into a temporary buffer of the whole segment.
+  if (cache == nullptr ||
+      size_t{total_samples} * sizeof(int16_t) > cache->getMaxBytes()) {
+    std::array<int16_t, kRenderBlockSize> block;
+    for (uint32_t first = 0; first < total_samples;
+         first += kRenderBlockSize) {
+      const uint32_t count = std::min(total_samples - first, kRenderBlockSize);
+      render(block.data(), first, count);
+      generator.addSamples(block.data(), count);
+    }
+    return;
+  }
+
+  // Round the phase so hits and misses produce the same output.
+  constexpr double kPhaseStep = kTwoPi / ToneCache::kPhaseSteps;
+  key.phase_index =
+      static_cast<uint32_t>(std::lround(angle / kPhaseStep)) %
+      ToneCache::kPhaseSteps;
+  angle = key.phase_index * kPhaseStep;
+
+  const ToneCache::Entry *cached = cache->find(key);
+  if (cached != nullptr) {
+    generator.addSamples(cached->samples.data(), total_samples);
+    angle = cached->end_angle;
+    return;
+  }
+
+  ToneCache::Entry entry;
+  entry.samples.resize(total_samples);
+  render(entry.samples.data(), 0, total_samples);
+  entry.end_angle = angle;
+  generator.addSamples(entry.samples.data(), total_samples);
+  cache->insert(key, std::move(entry));
+}
+
+} // namespace
+
+Generator::Generator() : Writer(), tone_cache_(nullptr) {
+}
+
+Generator::Generator(std::string output_file_path)
+    : Writer(output_file_path), tone_cache_(nullptr) {
+}
+
+Generator::Generator(int16_t *buffer, uint32_t buffer_size)
+    : Writer(buffer, buffer_size), tone_cache_(nullptr) {
+}
+
+Generator::~Generator() = default;
+
+Generator::Generator(Generator &&other) = default;
+Generator &Generator::operator=(Generator &&other) = default;
+
+void Generator::reset() {
+  wave_angle_ = 0.0;
+  tone_angles_.fill(0.0);
+  noise_position_ = 0;
+}
+
+void Generator::enableToneCache(size_t max_bytes) {
+  tone_cache_ = std::make_unique<ToneCache>(max_bytes);
+}
+
+void Generator::disableToneCache() {
+  tone_cache_.reset();
+}
+
+ToneCacheStats Generator::getToneCacheStats() const {
+  if (tone_cache_ == nullptr) {
+    return ToneCacheStats();
+  }
+  return tone_cache_->getStats();
+}
+
+void Generator::addSineWave(uint16_t frequency, double amplitude,
+                            uint16_t duration_ms) {
+
+  /**
+   * @brief The delta angle between samples.
+   */
+  const double d_wave = pi2() * frequency / SAMPLE_RATE;
+  const uint32_t total_samples = SAMPLE_RATE_MS * duration_ms;
+
+  /**
+   * @brief Filter to reduce the amplitude of the wave in the first and last
+   * SINE_WAVE_SAMPLES_TO_FILTER samples.
+   */
+  double filter = 0.0f;
+
+  const auto key = ToneCache::makeKey(ToneCache::Kind::SINE_WAVE, frequency,
+                                      amplitude, total_samples, 0);
+  addSegment(*this, tone_cache_.get(), key, wave_angle_,
+             [&](int16_t *output, uint32_t first, uint32_t count) {
+               renderFadedSine(output, first, count, total_samples, d_wave,
+                               amplitude, wave_angle_, filter);
+             });
+}
+
 void Generator::addSineWaveSamples(uint16_t frequency, double amplitude,
                                    uint32_t samples) {
   float offset = pi2() * frequency / SAMPLE_RATE; // The offset of the angle
                                                   // between samples
 
-  for (uint32_t i = 0; i < samples; i++) { // For each sample
-    wave_angle_ += offset;
-    int16_t sample = static_cast<int16_t>((amplitude * sin(wave_angle_)) *
-                                          MAX_SAMPLE_AMPLITUDE);
-    addSample(sample);
+  const auto key = ToneCache::makeKey(ToneCache::Kind::SINE_WAVE_SAMPLES,
+                                      frequency, amplitude, samples, 0);
+  addSegment(*this, tone_cache_.get(), key, wave_angle_,
+             [&](int16_t *output, uint32_t, uint32_t count) {
+               renderSine(output, count, offset, amplitude, wave_angle_);
+             });
+}
+
+void Generator::addSilence(uint32_t samples) {
+  const std::array<int16_t, kRenderBlockSize> silence{};
+  while (samples > 0) {
+    const uint32_t count = std::min(samples, kRenderBlockSize);
+    addSamples(silence.data(), count);
+    samples -= count;
+  }
+}
+
+void Generator::addMultiTone(const Tone *tones, size_t num_tones,
+                             uint32_t samples) {
+  if (num_tones > MAX_MULTI_TONES) {
+    fail(Status::INVALID_ARGUMENT, "Too many tones for addMultiTone.");
+    return;
+  }
 
-    if (wave_angle_ > pi2()) {
-      wave_angle_ -= pi2();
+  // Structure of arrays, one rotating phasor per tone. The inner loop runs
+  // across the tones so they are advanced together.
+  std::array<float, MAX_MULTI_TONES> real{};
+  std::array<float, MAX_MULTI_TONES> imag{};
+  std::array<float, MAX_MULTI_TONES> rotation_real{};
+  std::array<float, MAX_MULTI_TONES> rotation_imag{};
+  std::array<double, MAX_MULTI_TONES> d_angle{};
+  for (size_t k = 0; k < num_tones; k++) {
+    d_angle[k] = kTwoPi * tones[k].frequency / SAMPLE_RATE;
+    rotation_real[k] = static_cast<float>(std::cos(d_angle[k]));
+    rotation_imag[k] = static_cast<float>(std::sin(d_angle[k]));
+  }
+
+  std::array<float, kRenderBlockSize> mix;
+  std::array<int16_t, kRenderBlockSize> block;
+  while (samples > 0) {
+    const uint32_t count = std::min(samples, kRenderBlockSize);
+
+    // Restart each phasor from the exact phase every block so rounding in
+    // the recurrence can not accumulate.
+    for (size_t k = 0; k < num_tones; k++) {
+      real[k] = static_cast<float>(tones[k].amplitude *
+                                   std::cos(tone_angles_[k]));
+      imag[k] = static_cast<float>(tones[k].amplitude *
+                                   std::sin(tone_angles_[k]));
     }
+
+    for (uint32_t i = 0; i < count; i++) {
+      float sum = 0.0f;
+      for (size_t k = 0; k < num_tones; k++) {
+        const float next_real =
+            real[k] * rotation_real[k] - imag[k] * rotation_imag[k];
+        const float next_imag =
+            real[k] * rotation_imag[k] + imag[k] * rotation_real[k];
+        real[k] = next_real;
+        imag[k] = next_imag;
+        sum += next_imag;
+      }
+      mix[i] = sum;
+    }
+
+    for (size_t k = 0; k < num_tones; k++) {
+      tone_angles_[k] = std::fmod(tone_angles_[k] + d_angle[k] * count,
+                                  kTwoPi);
+    }
+
+    floatToSamples(mix.data(), block.data(), count, 1.0);
+    addSamples(block.data(), count);
+    samples -= count;
+  }
+}
+
+void Generator::addSweep(double start_hz, double end_hz, double amplitude,
+                         uint32_t samples, SweepShape shape) {
+  const bool exponential = shape == SweepShape::EXPONENTIAL;
+  if (exponential && (start_hz <= 0.0 || end_hz <= 0.0)) {
+    fail(Status::INVALID_ARGUMENT,
+         "Exponential sweeps need frequencies above 0.");
+    return;
+  }
+  if (samples == 0) {
+    return;
+  }
+
+  // The phase increment of sample n is d0 + n * dd (linear) or d0 * r^n
+  // (exponential), so the last sample is exactly at end_hz.
+  const double d0 = kTwoPi * start_hz / SAMPLE_RATE;
+  const double d1 = kTwoPi * end_hz / SAMPLE_RATE;
+  const double steps = samples > 1 ? samples - 1 : 1;
+  const double dd = (d1 - d0) / steps;
+  const double log_ratio = exponential ? std::log(d1 / d0) / steps : 0.0;
+
+  // Exponential sweeps are rendered as short linear chirps that match the
+  // exact increment at both ends of each segment. The phase at the start of
+  // every segment is computed in double precision, so neither shape drifts.
+  constexpr uint32_t kSegmentSize = 32;
+  std::array<float, kRenderBlockSize> wave;
+  std::array<int16_t, kRenderBlockSize> block;
+  uint32_t position = 0;
+  while (position < samples) {
+    const uint32_t count = std::min(samples - position, kRenderBlockSize);
+    for (uint32_t first = 0; first < count; first += kSegmentSize) {
+      const uint32_t length = std::min(count - first, kSegmentSize);
+      const double n = position + first;
+
+      double d_start = d0 + n * dd;
+      double segment_dd = dd;
+      double segment_angle = length * d_start + dd * length * (length - 1) / 2;
+      if (exponential) {
+        d_start = d0 * std::exp(log_ratio * n);
+        const double d_end = d0 * std::exp(log_ratio * (n + length - 1));
+        segment_dd = length > 1 ? (d_end - d_start) / (length - 1) : 0.0;
+        segment_angle = std::fabs(log_ratio) < 1e-12
+                            ? length * d_start
+                            : d_start * std::expm1(log_ratio * length) /
+                                  std::expm1(log_ratio);
+      }
+
+      renderChirp(wave.data() + first, length, wave_angle_, d_start,
+                  segment_dd);
+      wave_angle_ = std::fmod(wave_angle_ + segment_angle, kTwoPi);
+    }
+
+    floatToSamples(wave.data(), block.data(), count, amplitude);
+    addSamples(block.data(), count);
+    position += count;
+  }
+}
+
+void Generator::addMultiTone(const std::vector<Tone> &tones,
+                             uint32_t samples) {
+  addMultiTone(tones.data(), tones.size(), samples);
+}
+
+void Generator::addDtmf(const std::string &digits, uint16_t tone_ms,
+                        uint16_t gap_ms, double amplitude) {
+  constexpr std::array<double, 4> kRowFrequencies = {697, 770, 852, 941};
+  constexpr std::array<double, 4> kColumnFrequencies = {1209, 1336, 1477,
+                                                        1633};
+  constexpr std::string_view kKeypad = "123A456B789C*0#D";
+  auto find_key = [&](char digit) {
+    return kKeypad.find(static_cast<char>(
+        std::toupper(static_cast<unsigned char>(digit))));
+  };
+
+  // Check every digit first, so an invalid one adds nothing.
+  for (char digit : digits) {
+    if (find_key(digit) == std::string_view::npos) {
+      fail(Status::INVALID_ARGUMENT, "Invalid DTMF digit.");
+      return;
+    }
+  }
+
+  for (char digit : digits) {
+    const size_t key = find_key(digit);
+
+    Tone tones[2];
+    tones[0].frequency = kRowFrequencies[key / 4];
+    tones[0].amplitude = amplitude / 2;
+    tones[1].frequency = kColumnFrequencies[key % 4];
+    tones[1].amplitude = amplitude / 2;
+
+    addMultiTone(tones, 2, SAMPLE_RATE_MS * tone_ms);
+    addSilence(SAMPLE_RATE_MS * gap_ms);
   }
 }
 
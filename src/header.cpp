@@ -6,33 +6,19 @@
  * @copyright Copyright (c) 2023
  */
 
+#include <algorithm>
 #include <array>
 #include <filesystem>
 
+#include "error.hpp"
 #include "file.hpp"
 #include "wav_gen.hpp"
 
 namespace wavgen {
 
-inline constexpr uint32_t kWavHeaderSize = 44;
-
-// RIFF****WAVEfmt
-const std::string kRiffChunkDescriptor = "RIFF";
-const std::string kWavFormat = "WAVE";
-const std::string kFormatChunkDescriptor = "fmt ";
-
-inline constexpr uint32_t kFormatChunkSize = 16;
-inline constexpr uint32_t kFormatCode = 1;
-inline constexpr uint32_t kNumChannels = 1;
-
-inline constexpr uint32_t kByteRate =
-    (SAMPLE_RATE * SAMPLE_RESOLUTION * kNumChannels) / 8;
-inline constexpr uint32_t kBlockAlign = (SAMPLE_RESOLUTION * kNumChannels) / 8;
-const std::string kDataChunkDescriptor = "data";
-
 std::ofstream &operator<<(std::ofstream &out_file, const WavHeader &header) {
   if (!out_file.is_open()) {
-    throw std::runtime_error("Failed to write header. File not open.");
+    WAVGEN_THROW(std::runtime_error("Failed to write header. File not open."));
   }
 
   // keep track of the initial position so we can jump back to it later.
@@ -42,19 +28,8 @@ std::ofstream &operator<<(std::ofstream &out_file, const WavHeader &header) {
   out_file.seekp(0, std::ios::beg);
 
   // Write the header data.
-  out_file << kRiffChunkDescriptor;
-  writeBytes<4>(out_file, header.file_size);
-  out_file << kWavFormat;
-  out_file << kFormatChunkDescriptor;
-  writeBytes<4>(out_file, kFormatChunkSize);
-  writeBytes<2>(out_file, kFormatCode);
-  writeBytes<2>(out_file, kNumChannels);
-  writeBytes<4>(out_file, SAMPLE_RATE);
-  writeBytes<4>(out_file, kByteRate);
-  writeBytes<2>(out_file, kBlockAlign);
-  writeBytes<2>(out_file, SAMPLE_RESOLUTION);
-  out_file << kDataChunkDescriptor;
-  writeBytes<4>(out_file, header.data_chunk_size);
+  const auto bytes = packHeader(header);
+  out_file.write(bytes.data(), bytes.size());
 
   // Jump back to the initial position.
   out_file.seekp(initial_position);
@@ -63,13 +38,14 @@ std::ofstream &operator<<(std::ofstream &out_file, const WavHeader &header) {
 
 std::ifstream &operator>>(std::ifstream &in_file, WavHeader &header) {
   if (!in_file.is_open()) {
-    throw std::runtime_error("Failed to read header. File not open.");
+    WAVGEN_THROW(std::runtime_error("Failed to read header. File not open."));
   }
 
   // Ensure that the file is large enough to contain a header.
   const uint32_t file_size = calculateFileSize(in_file);
   if (file_size < kWavHeaderSize) {
-    throw std::runtime_error("Failed to read header. File is too small.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. File is too small."));
   }
 
   // Read the header data into a buffer.
@@ -81,7 +57,8 @@ std::ifstream &operator>>(std::ifstream &in_file, WavHeader &header) {
   const std::string riff_chunk_descriptor =
       std::string(header_data.begin(), header_data.begin() + 4);
   if (riff_chunk_descriptor != kRiffChunkDescriptor) {
-    throw std::runtime_error("Failed to read header. Invalid RIFF chunk.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid RIFF chunk."));
   }
 
   // Read the size of the overall file.
@@ -91,67 +68,77 @@ std::ifstream &operator>>(std::ifstream &in_file, WavHeader &header) {
   const std::string wav_format =
       std::string(header_data.begin() + 8, header_data.begin() + 12);
   if (wav_format != kWavFormat) {
-    throw std::runtime_error("Failed to read header. Invalid WAV format.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid WAV format."));
   }
 
   // Check the format chunk descriptor.
   const std::string format_chunk_descriptor =
       std::string(header_data.begin() + 12, header_data.begin() + 16);
   if (format_chunk_descriptor != kFormatChunkDescriptor) {
-    throw std::runtime_error("Failed to read header. Invalid format chunk.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid format chunk."));
   }
 
   // Check the format chunk size.
   const uint32_t format_chunk_size =
       *reinterpret_cast<uint32_t *>(&header_data[16]);
   if (format_chunk_size != kFormatChunkSize) {
-    throw std::runtime_error(
-        "Failed to read header. Invalid format chunk size.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid format chunk "
+                           "size."));
   }
 
   // Check the format code.
   const uint16_t format_code = *reinterpret_cast<uint16_t *>(&header_data[20]);
   if (format_code != kFormatCode) {
-    throw std::runtime_error("Failed to read header. Invalid format code.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid format code."));
   }
 
   // Check the number of channels.
   const uint16_t num_channels = *reinterpret_cast<uint16_t *>(&header_data[22]);
   if (num_channels != kNumChannels) {
-    throw std::runtime_error("Failed to read header. Invalid number of "
-                             "channels. Only mono files are supported.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid number of channels. "
+                           "Only mono files are supported."));
   }
 
   // Read the sample rate.
   const uint32_t sample_rate = *reinterpret_cast<uint32_t *>(&header_data[24]);
   if (sample_rate != SAMPLE_RATE) {
-    throw std::runtime_error("Failed to read header. Invalid sample rate.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid sample rate."));
   }
 
   // Read the byte rate.
   const uint32_t byte_rate = *reinterpret_cast<uint32_t *>(&header_data[28]);
   if (byte_rate != kByteRate) {
-    throw std::runtime_error("Failed to read header. Invalid byte rate.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid byte rate."));
   }
 
   // Read the block align.
   const uint16_t block_align = *reinterpret_cast<uint16_t *>(&header_data[32]);
   if (block_align != kBlockAlign) {
-    throw std::runtime_error("Failed to read header. Invalid block align.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid block align."));
   }
 
   // Read the bits per sample.
   const uint16_t bits_per_sample =
       *reinterpret_cast<uint16_t *>(&header_data[34]);
   if (bits_per_sample != SAMPLE_RESOLUTION) {
-    throw std::runtime_error("Failed to read header. Invalid bits per sample.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid bits per sample."));
   }
 
   // Check the data chunk descriptor.
   const std::string data_chunk_descriptor =
       std::string(header_data.begin() + 36, header_data.begin() + 40);
   if (data_chunk_descriptor != kDataChunkDescriptor) {
-    throw std::runtime_error("Failed to read header. Invalid data chunk.");
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid data chunk."));
   }
 
   // Read the data chunk size.
@@ -160,4 +147,116 @@ std::ifstream &operator>>(std::ifstream &in_file, WavHeader &header) {
   return in_file;
 }
 
-} // namespace wavgen
\ No newline at end of file
+namespace {
+
+inline constexpr uint16_t kFormatPcm = 1;
+inline constexpr uint16_t kFormatFloat = 3;
+inline constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+uint32_t getLe(const uint8_t *bytes, size_t num_bytes) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < num_bytes; i++) {
+    value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+bool isChunk(const uint8_t *bytes, std::string_view id) {
+  return std::equal(id.begin(), id.end(), bytes);
+}
+
+SampleFormat toSampleFormat(uint16_t format_code, uint16_t bits_per_sample) {
+  if (format_code == kFormatFloat && bits_per_sample == 32) {
+    return SampleFormat::FLOAT_32;
+  }
+  if (format_code == kFormatPcm) {
+    switch (bits_per_sample) {
+    case 8:
+      return SampleFormat::PCM_8;
+    case 16:
+      return SampleFormat::PCM_16;
+    case 24:
+      return SampleFormat::PCM_24;
+    case 32:
+      return SampleFormat::PCM_32;
+    default:
+      break;
+    }
+  }
+  WAVGEN_THROW(
+      std::runtime_error("Failed to read header. Unsupported sample format."));
+}
+
+} // namespace
+
+WavLayout readLayout(int fd, uint64_t file_size, bool check_data_size) {
+  std::array<uint8_t, 12> riff{};
+  if (readAt(fd, riff.data(), riff.size(), 0) != riff.size() ||
+      !isChunk(riff.data(), kRiffChunkDescriptor)) {
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid RIFF chunk."));
+  }
+  if (!isChunk(riff.data() + 8, kWavFormat)) {
+    WAVGEN_THROW(
+        std::runtime_error("Failed to read header. Invalid WAV format."));
+  }
+
+  WavLayout layout;
+  bool found_format = false;
+  uint64_t offset = riff.size();
+  while (offset + 8 <= file_size) {
+    std::array<uint8_t, 8> chunk{};
+    readAt(fd, chunk.data(), chunk.size(), offset);
+    const uint32_t chunk_size = getLe(chunk.data() + 4, 4);
+
+    if (isChunk(chunk.data(), kFormatChunkDescriptor)) {
+      // The extensible format is 40 bytes, the rest is not needed.
+      std::array<uint8_t, 40> fmt{};
+      const size_t fmt_size = std::min<size_t>(chunk_size, fmt.size());
+      if (fmt_size < kFormatChunkSize ||
+          readAt(fd, fmt.data(), fmt_size, offset + 8) != fmt_size) {
+        WAVGEN_THROW(
+            std::runtime_error("Failed to read header. Invalid format chunk "
+                               "size."));
+      }
+      uint16_t format_code = static_cast<uint16_t>(getLe(&fmt[0], 2));
+      if (format_code == kFormatExtensible && fmt_size >= 26) {
+        format_code = static_cast<uint16_t>(getLe(&fmt[24], 2));
+      }
+      const auto num_channels = static_cast<uint16_t>(getLe(&fmt[2], 2));
+      const auto bits_per_sample = static_cast<uint16_t>(getLe(&fmt[14], 2));
+
+      layout.format.sample_format =
+          toSampleFormat(format_code, bits_per_sample);
+      layout.format.num_channels = num_channels;
+      layout.format.sample_rate = getLe(&fmt[4], 4);
+      layout.block_align = static_cast<uint16_t>(getLe(&fmt[12], 2));
+      if (num_channels == 0 || layout.format.sample_rate == 0 ||
+          layout.block_align != num_channels * (bits_per_sample / 8)) {
+        WAVGEN_THROW(
+            std::runtime_error("Failed to read header. Invalid block align."));
+      }
+      found_format = true;
+    } else if (isChunk(chunk.data(), kDataChunkDescriptor)) {
+      if (!found_format) {
+        WAVGEN_THROW(
+            std::runtime_error("Failed to read header. Invalid format chunk."));
+      }
+      layout.data_offset = offset + 8;
+      layout.data_size = chunk_size;
+      if (check_data_size && layout.data_offset + chunk_size > file_size) {
+        WAVGEN_THROW(
+            std::runtime_error("More samples in header than can exist in "
+                               "file."));
+      }
+      return layout;
+    }
+
+    // Chunks are padded to an even size.
+    offset += 8 + uint64_t{chunk_size} + (chunk_size & 1);
+  }
+  WAVGEN_THROW(
+      std::runtime_error("Failed to read header. Invalid data chunk."));
+}
+
+} // namespace wavgen
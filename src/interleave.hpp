@@ -0,0 +1,193 @@
+/**
+ * @file interleave.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Kernels that convert between planar and interleaved channels.
+ * @date 2023-10-28
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef INTERLEAVE_HPP_
+#define INTERLEAVE_HPP_
+
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace wavgen {
+
+/**
+ * @brief Interleave planar channels into frames. Stereo and 4 channel input
+ * is shuffled 8 frames at a time with SSE2 or NEON where available, other
+ * channel counts and the remaining frames use a scalar loop.
+ *
+ * @param channels - One pointer per channel.
+ * @param num_channels - The number of channels.
+ * @param first_frame - The index of the first frame to read from each
+ * channel.
+ * @param num_frames - The number of frames to interleave.
+ * @param output - num_frames * num_channels samples.
+ */
+inline void interleave(const int16_t *const *channels, uint16_t num_channels,
+                       uint32_t first_frame, uint32_t num_frames,
+                       int16_t *output) {
+  uint32_t frame = 0;
+#if defined(__SSE2__)
+  auto load = [&](uint16_t channel) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+        channels[channel] + first_frame + frame));
+  };
+  auto store = [&](uint32_t index, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output + index), value);
+  };
+  if (num_channels == 2) {
+    for (; frame + 8 <= num_frames; frame += 8) {
+      const __m128i left = load(0);
+      const __m128i right = load(1);
+      store(frame * 2, _mm_unpacklo_epi16(left, right));
+      store(frame * 2 + 8, _mm_unpackhi_epi16(left, right));
+    }
+  } else if (num_channels == 4) {
+    for (; frame + 8 <= num_frames; frame += 8) {
+      const __m128i a = load(0);
+      const __m128i b = load(1);
+      const __m128i c = load(2);
+      const __m128i d = load(3);
+      const __m128i ab_low = _mm_unpacklo_epi16(a, b);
+      const __m128i ab_high = _mm_unpackhi_epi16(a, b);
+      const __m128i cd_low = _mm_unpacklo_epi16(c, d);
+      const __m128i cd_high = _mm_unpackhi_epi16(c, d);
+      store(frame * 4, _mm_unpacklo_epi32(ab_low, cd_low));
+      store(frame * 4 + 8, _mm_unpackhi_epi32(ab_low, cd_low));
+      store(frame * 4 + 16, _mm_unpacklo_epi32(ab_high, cd_high));
+      store(frame * 4 + 24, _mm_unpackhi_epi32(ab_high, cd_high));
+    }
+  }
+#elif defined(__ARM_NEON)
+  if (num_channels == 2) {
+    for (; frame + 8 <= num_frames; frame += 8) {
+      const uint32_t index = first_frame + frame;
+      int16x8x2_t value;
+      value.val[0] = vld1q_s16(channels[0] + index);
+      value.val[1] = vld1q_s16(channels[1] + index);
+      vst2q_s16(output + frame * 2, value);
+    }
+  } else if (num_channels == 4) {
+    for (; frame + 8 <= num_frames; frame += 8) {
+      const uint32_t index = first_frame + frame;
+      int16x8x4_t value;
+      for (int channel = 0; channel < 4; channel++) {
+        value.val[channel] = vld1q_s16(channels[channel] + index);
+      }
+      vst4q_s16(output + frame * 4, value);
+    }
+  }
+#endif
+  for (; frame < num_frames; frame++) {
+    for (uint16_t channel = 0; channel < num_channels; channel++) {
+      output[frame * num_channels + channel] =
+          channels[channel][first_frame + frame];
+    }
+  }
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief Split 8 pairs of 16-bit values into the first and the second value
+ * of each pair.
+ */
+inline void deinterleavePairs(__m128i low, __m128i high, __m128i &first,
+                              __m128i &second) {
+  // Sign extend each half of the 32-bit lanes, then pack them back. The
+  // values already fit, so the saturating pack is exact.
+  first = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(low, 16), 16),
+                          _mm_srai_epi32(_mm_slli_epi32(high, 16), 16));
+  second = _mm_packs_epi32(_mm_srai_epi32(low, 16), _mm_srai_epi32(high, 16));
+}
+#endif
+
+/**
+ * @brief Split interleaved frames into planar channels, the reverse of
+ * interleave().
+ *
+ * @param input - num_frames * num_channels samples.
+ * @param num_channels - The number of channels.
+ * @param num_frames - The number of frames to split.
+ * @param channels - One pointer per channel.
+ * @param first_frame - The index of the first frame to write to each
+ * channel.
+ */
+inline void deinterleave(const int16_t *input, uint16_t num_channels,
+                         uint32_t num_frames, int16_t *const *channels,
+                         uint32_t first_frame) {
+  uint32_t frame = 0;
+#if defined(__SSE2__)
+  auto load = [&](uint32_t index) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + index));
+  };
+  auto store = [&](uint16_t channel, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(channels[channel] +
+                                                 first_frame + frame),
+                     value);
+  };
+  if (num_channels == 2) {
+    for (; frame + 8 <= num_frames; frame += 8) {
+      __m128i left;
+      __m128i right;
+      deinterleavePairs(load(frame * 2), load(frame * 2 + 8), left, right);
+      store(0, left);
+      store(1, right);
+    }
+  } else if (num_channels == 4) {
+    for (; frame + 8 <= num_frames; frame += 8) {
+      // Split into channels a, c and b, d, then split those again.
+      __m128i ac_low;
+      __m128i bd_low;
+      __m128i ac_high;
+      __m128i bd_high;
+      deinterleavePairs(load(frame * 4), load(frame * 4 + 8), ac_low, bd_low);
+      deinterleavePairs(load(frame * 4 + 16), load(frame * 4 + 24), ac_high,
+                        bd_high);
+      __m128i a;
+      __m128i b;
+      __m128i c;
+      __m128i d;
+      deinterleavePairs(ac_low, ac_high, a, c);
+      deinterleavePairs(bd_low, bd_high, b, d);
+      store(0, a);
+      store(1, b);
+      store(2, c);
+      store(3, d);
+    }
+  }
+#elif defined(__ARM_NEON)
+  if (num_channels == 2) {
+    for (; frame + 8 <= num_frames; frame += 8) {
+      const int16x8x2_t value = vld2q_s16(input + frame * 2);
+      vst1q_s16(channels[0] + first_frame + frame, value.val[0]);
+      vst1q_s16(channels[1] + first_frame + frame, value.val[1]);
+    }
+  } else if (num_channels == 4) {
+    for (; frame + 8 <= num_frames; frame += 8) {
+      const int16x8x4_t value = vld4q_s16(input + frame * 4);
+      for (int channel = 0; channel < 4; channel++) {
+        vst1q_s16(channels[channel] + first_frame + frame,
+                  value.val[channel]);
+      }
+    }
+  }
+#endif
+  for (; frame < num_frames; frame++) {
+    for (uint16_t channel = 0; channel < num_channels; channel++) {
+      channels[channel][first_frame + frame] =
+          input[frame * num_channels + channel];
+    }
+  }
+}
+
+} // namespace wavgen
+
+#endif /* INTERLEAVE_HPP_ */
@@ -0,0 +1,186 @@
+/**
+ * @file noise.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Deterministic noise sources for the generator.
+ * @date 2023-08-19
+ * @copyright Copyright (c) 2023
+ */
+
+#include <array>
+#include <cmath>
+
+#include "noise.hpp"
+#include "oscillator.hpp"
+#include "wav_filter.hpp"
+#include "wav_gen.hpp"
+
+namespace wavgen {
+
+namespace {
+
+/**
+ * @brief The number of rows of the pink noise generator, not including the
+ * white noise row that changes every sample. Row k changes every 2^k samples.
+ */
+inline constexpr uint32_t kPinkRows = 15;
+
+uint32_t streamId(NoiseStream stream) {
+  return static_cast<uint32_t>(stream);
+}
+
+/**
+ * @brief A row value for the pink noise generator, a signed 16-bit integer so
+ * the running sum is exact.
+ */
+int32_t pinkRow(uint64_t seed, uint32_t row, uint64_t position) {
+  const uint32_t stream = streamId(NoiseStream::PINK_ROWS) + row;
+  return static_cast<int32_t>(noiseBits(seed, stream, position >> row) >> 16) -
+         32768;
+}
+
+/**
+ * @brief Fill a block with gaussian noise using the Box-Muller transform. Only
+ * one output is used per pair of uniforms so each sample only depends on its
+ * own position.
+ */
+void fillGaussianNoise(float *output, uint32_t num_samples, uint64_t seed,
+                       uint64_t position, float rms) {
+  const float kPi = static_cast<float>(kTwoPi / 2);
+  std::array<float, kRenderBlockSize> angle;
+  fillUniformNoise(output, num_samples, seed,
+                   streamId(NoiseStream::GAUSSIAN_MAGNITUDE), position);
+  fillUniformNoise(angle.data(), num_samples, seed,
+                   streamId(NoiseStream::GAUSSIAN_ANGLE), position);
+  for (uint32_t i = 0; i < num_samples; i++) {
+    const float u1 = 1.0f - (output[i] + 1.0f) * 0.5f; // (0, 1]
+    output[i] = rms * std::sqrt(-2.0f * std::log(u1)) *
+                std::cos(kPi * (angle[i] + 1.0f));
+  }
+}
+
+} // namespace
+
+void Generator::setNoiseSeed(uint64_t seed) {
+  noise_seed_ = seed;
+  noise_position_ = 0;
+}
+
+void Generator::setNoisePosition(uint64_t position) {
+  noise_position_ = position;
+}
+
+void Generator::addWhiteNoise(double amplitude, uint32_t samples) {
+  std::array<float, kRenderBlockSize> noise;
+  std::array<int16_t, kRenderBlockSize> block;
+  while (samples > 0) {
+    const uint32_t count = std::min(samples, kRenderBlockSize);
+    fillUniformNoise(noise.data(), count, noise_seed_,
+                     streamId(NoiseStream::WHITE), noise_position_);
+    floatToSamples(noise.data(), block.data(), count, amplitude);
+    addSamples(block.data(), count);
+    noise_position_ += count;
+    samples -= count;
+  }
+}
+
+void Generator::addGaussianNoise(double rms, uint32_t samples) {
+  std::array<float, kRenderBlockSize> noise;
+  std::array<int16_t, kRenderBlockSize> block;
+  while (samples > 0) {
+    const uint32_t count = std::min(samples, kRenderBlockSize);
+    fillGaussianNoise(noise.data(), count, noise_seed_, noise_position_,
+                      static_cast<float>(rms));
+    floatToSamples(noise.data(), block.data(), count, 1.0);
+    addSamples(block.data(), count);
+    noise_position_ += count;
+    samples -= count;
+  }
+}
+
+void Generator::addPinkNoise(double amplitude, uint32_t samples) {
+  constexpr float kScale = 1.0f / (32768.0f * (kPinkRows + 1));
+
+  // The rows are rebuilt from the position, there is no state carried
+  // between calls.
+  std::array<int32_t, kPinkRows + 1> rows{};
+  int64_t sum = 0;
+  for (uint32_t row = 1; row <= kPinkRows; row++) {
+    rows[row] = pinkRow(noise_seed_, row, noise_position_);
+    sum += rows[row];
+  }
+
+  std::array<float, kRenderBlockSize> noise;
+  std::array<int16_t, kRenderBlockSize> block;
+  while (samples > 0) {
+    const uint32_t count = std::min(samples, kRenderBlockSize);
+
+    // The white row, every sample.
+    fillUniformNoise(noise.data(), count, noise_seed_,
+                     streamId(NoiseStream::WHITE), noise_position_);
+
+    for (uint32_t i = 0; i < count; i++) {
+      // Row k changes when the position crosses a multiple of 2^k.
+      const uint64_t position = noise_position_ + i;
+      for (uint32_t row = 1; row <= kPinkRows; row++) {
+        if ((position & ((uint64_t{1} << row) - 1)) != 0) {
+          break;
+        }
+        const int32_t value = pinkRow(noise_seed_, row, position);
+        sum += value - rows[row];
+        rows[row] = value;
+      }
+      noise[i] = static_cast<float>(sum) * kScale +
+                 noise[i] * (1.0f / (kPinkRows + 1));
+    }
+
+    floatToSamples(noise.data(), block.data(), count, amplitude);
+    addSamples(block.data(), count);
+    noise_position_ += count;
+    samples -= count;
+  }
+}
+
+void Generator::addBandLimitedNoise(double low_hz, double high_hz, double rms,
+                                    uint32_t samples) {
+  constexpr double kNyquist = SAMPLE_RATE / 2.0;
+  if (!(low_hz >= 0.0 && low_hz < high_hz && high_hz <= kNyquist)) {
+    fail(Status::INVALID_ARGUMENT,
+         "The noise band must be within 0 Hz and SAMPLE_RATE / 2.");
+    return;
+  }
+
+  // Fourth order Butterworth high and low pass, the noise bandwidth is then
+  // close to high_hz - low_hz. A band edge at 0 Hz or at the Nyquist
+  // frequency needs no filter (and the design would be degenerate there).
+  constexpr double kQ1 = 0.5411961001461970;
+  constexpr double kQ2 = 1.3065629648763764;
+  BiquadFilter filter;
+  if (low_hz > 0.0) {
+    filter.addSection(BiquadFilter::highPass(low_hz, kQ1));
+    filter.addSection(BiquadFilter::highPass(low_hz, kQ2));
+  }
+  if (high_hz < kNyquist) {
+    filter.addSection(BiquadFilter::lowPass(high_hz, kQ1));
+    filter.addSection(BiquadFilter::lowPass(high_hz, kQ2));
+  }
+
+  // White noise of variance s^2 has s^2 * bandwidth / nyquist of its power
+  // in the band, scale the input so the output has the requested RMS.
+  const double bandwidth = std::max(high_hz - low_hz, 1.0);
+  const double input_rms = rms * std::sqrt((SAMPLE_RATE / 2.0) / bandwidth);
+
+  std::array<float, kRenderBlockSize> noise;
+  std::array<int16_t, kRenderBlockSize> block;
+  while (samples > 0) {
+    const uint32_t count = std::min(samples, kRenderBlockSize);
+    fillGaussianNoise(noise.data(), count, noise_seed_, noise_position_,
+                      static_cast<float>(input_rms));
+    filter.process(noise.data(), count);
+    floatToSamples(noise.data(), block.data(), count, 1.0);
+    addSamples(block.data(), count);
+    noise_position_ += count;
+    samples -= count;
+  }
+}
+
+} // namespace wavgen
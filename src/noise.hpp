@@ -0,0 +1,94 @@
+/**
+ * @file noise.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief A counter based random number generator for the noise sources.
+ * @date 2023-08-19
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef NOISE_HPP_
+#define NOISE_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace wavgen {
+
+/**
+ * @brief The independent random streams used by the noise sources.
+ */
+enum class NoiseStream : uint32_t {
+  WHITE = 0,
+  GAUSSIAN_MAGNITUDE = 1,
+  GAUSSIAN_ANGLE = 2,
+  PINK_ROWS = 16 // PINK_ROWS + row for each row of the pink noise generator.
+};
+
+/**
+ * @brief An integer hash with good avalanche behavior (lowbias32 by
+ * Chris Wellons). Only 32-bit multiplies and shifts, so loops over it
+ * vectorize.
+ */
+inline uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return x;
+}
+
+/**
+ * @brief The key for a range of 2^32 consecutive indices of a stream.
+ */
+inline uint32_t noiseKey(uint64_t seed, uint32_t stream, uint32_t index_high) {
+  uint32_t key = hash32(static_cast<uint32_t>(seed) ^ (stream * 0x9e3779b9U));
+  key = hash32(key ^ static_cast<uint32_t>(seed >> 32));
+  return hash32(key ^ index_high);
+}
+
+/**
+ * @brief Random bits for a single index of a stream. The value only depends
+ * on the seed, stream and index, never on what was generated before.
+ */
+inline uint32_t noiseBits(uint64_t seed, uint32_t stream, uint64_t index) {
+  return hash32(static_cast<uint32_t>(index) ^
+                noiseKey(seed, stream, static_cast<uint32_t>(index >> 32)));
+}
+
+/**
+ * @brief Convert random bits to a uniform float in [-1, 1).
+ */
+inline float bitsToUniform(uint32_t bits) {
+  return static_cast<float>(bits >> 8) * (1.0f / 8388608.0f) - 1.0f;
+}
+
+/**
+ * @brief Fill a block with uniform noise in [-1, 1) for indices
+ * [position, position + num_samples) of a stream.
+ */
+inline void fillUniformNoise(float *output, uint32_t num_samples,
+                             uint64_t seed, uint32_t stream,
+                             uint64_t position) {
+  while (num_samples > 0) {
+    // The key only changes every 2^32 samples, keep it out of the loop.
+    const uint32_t low = static_cast<uint32_t>(position);
+    const uint32_t key =
+        noiseKey(seed, stream, static_cast<uint32_t>(position >> 32));
+    const uint32_t count = static_cast<uint32_t>(
+        std::min<uint64_t>(num_samples, (uint64_t{1} << 32) - low));
+
+    for (uint32_t i = 0; i < count; i++) {
+      output[i] = bitsToUniform(hash32((low + i) ^ key));
+    }
+
+    output += count;
+    position += count;
+    num_samples -= count;
+  }
+}
+
+} // namespace wavgen
+
+#endif /* NOISE_HPP_ */
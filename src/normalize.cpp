@@ -0,0 +1,141 @@
+/**
+ * @file normalize.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Streaming level measurement and in place normalization.
+ * @date 2023-09-02
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "file.hpp"
+#include "wav_gen.hpp"
+#include "wav_overview.hpp"
+#include "wav_tools.hpp"
+
+namespace wavgen {
+
+namespace {
+
+/**
+ * @brief The number of samples processed at a time when streaming.
+ */
+inline constexpr uint32_t kStreamBlockSize = 1 << 16;
+
+/**
+ * @brief The number of samples in the data chunk, limited to what actually
+ * exists in the file.
+ */
+uint32_t dataChunkSamples(const WavHeader &header, uint64_t file_size) {
+  const uint64_t available = file_size > HEADER_SIZE ? file_size - HEADER_SIZE
+                                                     : 0;
+  return static_cast<uint32_t>(
+      std::min<uint64_t>(header.data_chunk_size, available) / 2);
+}
+
+/**
+ * @brief Multiply a block of samples by a gain, rounding and saturating to
+ * the 16-bit range. Clamping after the rounding keeps the loop branch free
+ * so it vectorizes.
+ */
+void applyGain(int16_t *samples, uint32_t num_samples, float gain) {
+  for (uint32_t i = 0; i < num_samples; i++) {
+    float value = samples[i] * gain;
+    value += value < 0.0f ? -0.5f : 0.5f;
+    samples[i] = static_cast<int16_t>(std::clamp(value, -32768.0f, 32767.0f));
+  }
+}
+
+} // namespace
+
+LevelStats measureLevels(const std::string &file_path) {
+  const WavHeader header = readHeader(file_path);
+  const FileDescriptor file = openFile(file_path, O_RDONLY);
+  const uint32_t num_samples =
+      dataChunkSamples(header, calculateFileSize(file));
+
+  LevelStats stats;
+  stats.num_samples = num_samples;
+
+  std::vector<int16_t> block(kStreamBlockSize);
+  double sum_of_squares = 0.0;
+  for (uint32_t offset = 0; offset < num_samples;
+       offset += kStreamBlockSize) {
+    const uint32_t count = std::min(kStreamBlockSize, num_samples - offset);
+    readAt(file, block.data(), count * sizeof(int16_t),
+           HEADER_SIZE + uint64_t{offset} * sizeof(int16_t));
+
+    // Integer accumulators within a block are exact and vectorize.
+    int32_t peak = 0;
+    int64_t block_sum = 0;
+    for (uint32_t i = 0; i < count; i++) {
+      const int32_t sample = block[i];
+      peak = std::max(peak, sample < 0 ? -sample : sample);
+      block_sum += sample * sample;
+    }
+    stats.peak = std::max(stats.peak, peak);
+    sum_of_squares += static_cast<double>(block_sum);
+  }
+
+  if (num_samples > 0) {
+    stats.rms = std::sqrt(sum_of_squares / num_samples);
+  }
+  return stats;
+}
+
+NormalizeResult normalize(const std::string &file_path, NormalizeMode mode,
+                          double target) {
+  NormalizeResult result;
+  result.before = measureLevels(file_path);
+
+  const double level = mode == NormalizeMode::PEAK ? result.before.peak
+                                                   : result.before.rms;
+  if (level <= 0.0) {
+    return result; // Silent, nothing to scale.
+  }
+  result.gain = target * MAX_SAMPLE_AMPLITUDE / level;
+
+  const uint32_t num_samples = result.before.num_samples;
+  const float gain = static_cast<float>(result.gain);
+  Overview::removeSidecar(file_path);
+  const FileDescriptor file = openFile(file_path, O_RDWR);
+  const uint64_t file_size = calculateFileSize(file);
+
+  // Map the file and scale the data chunk in place.
+  void *mapping = ::mmap(nullptr, file_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, file.get(), 0);
+  if (mapping != MAP_FAILED) {
+    ::madvise(mapping, file_size, MADV_SEQUENTIAL);
+    int16_t *samples = reinterpret_cast<int16_t *>(
+        static_cast<char *>(mapping) + HEADER_SIZE);
+    for (uint32_t offset = 0; offset < num_samples;
+         offset += kStreamBlockSize) {
+      applyGain(samples + offset,
+                std::min(kStreamBlockSize, num_samples - offset), gain);
+    }
+    const bool synced = ::msync(mapping, file_size, MS_SYNC) == 0;
+    ::munmap(mapping, file_size);
+    if (!synced) {
+      throw std::runtime_error("Failed to write normalized samples.");
+    }
+    return result;
+  }
+
+  // Fall back to rewriting the file one block at a time.
+  std::vector<int16_t> block(kStreamBlockSize);
+  for (uint32_t offset = 0; offset < num_samples;
+       offset += kStreamBlockSize) {
+    const uint32_t count = std::min(kStreamBlockSize, num_samples - offset);
+    const uint64_t position = HEADER_SIZE + uint64_t{offset} * sizeof(int16_t);
+    readAt(file, block.data(), count * sizeof(int16_t), position);
+    applyGain(block.data(), count, gain);
+    writeAt(file, block.data(), count * sizeof(int16_t), position);
+  }
+  return result;
+}
+
+} // namespace wavgen
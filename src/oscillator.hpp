@@ -0,0 +1,138 @@
+/**
+ * @file oscillator.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Sample rendering kernels shared by the generators.
+ * @date 2023-08-12
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef OSCILLATOR_HPP_
+#define OSCILLATOR_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "wav_gen.hpp"
+
+namespace wavgen {
+
+inline constexpr double kTwoPi = 6.283185307179586;
+
+/**
+ * @brief The number of samples the generators render at a time before
+ * handing them to the Writer.
+ */
+inline constexpr uint32_t kRenderBlockSize = 256;
+
+/**
+ * @brief Render a constant frequency sine wave into a buffer.
+ *
+ * @param output - The buffer to render into.
+ * @param num_samples - The number of samples to render.
+ * @param d_angle - The phase increment per sample in radians.
+ * @param amplitude - The amplitude of the sine wave (0.0 - 1.0).
+ * @param angle - The phase, updated so consecutive calls are continuous.
+ */
+inline void renderSine(int16_t *output, uint32_t num_samples, double d_angle,
+                       double amplitude, double &angle) {
+  for (uint32_t i = 0; i < num_samples; i++) {
+    angle += d_angle;
+    output[i] = static_cast<int16_t>((amplitude * std::sin(angle)) *
+                                     MAX_SAMPLE_AMPLITUDE);
+    if (angle > kTwoPi) {
+      angle -= kTwoPi;
+    }
+  }
+}
+
+/**
+ * @brief A unit complex number, the cosine and sine of an angle.
+ */
+struct Phasor {
+  float real = 1.0f;
+  float imag = 0.0f;
+};
+
+inline Phasor makePhasor(double angle) {
+  return {static_cast<float>(std::cos(angle)),
+          static_cast<float>(std::sin(angle))};
+}
+
+/**
+ * @brief Rotate a phasor by a step before each sample and output its
+ * imaginary part, rotating the step itself by chirp after each sample. Each
+ * sample depends on the previous one, so this loop is scalar.
+ *
+ * @param output - The buffer to render into.
+ * @param num_samples - The number of samples to render.
+ * @param phasor - The phase, updated to the phase of the last sample.
+ * @param step - The rotation of the first sample, updated for the next one.
+ * @param chirp - The rotation of the step per sample, the identity phasor
+ * for a constant frequency (the multiplications by it are then exact).
+ */
+inline void rotatePhasor(float *output, uint32_t num_samples, Phasor &phasor,
+                         Phasor &step, Phasor chirp) {
+  float real = phasor.real;
+  float imag = phasor.imag;
+  float step_real = step.real;
+  float step_imag = step.imag;
+  for (uint32_t i = 0; i < num_samples; i++) {
+    const float next_real = real * step_real - imag * step_imag;
+    const float next_imag = real * step_imag + imag * step_real;
+    real = next_real;
+    imag = next_imag;
+    output[i] = imag;
+
+    const float next_step_real =
+        step_real * chirp.real - step_imag * chirp.imag;
+    const float next_step_imag =
+        step_real * chirp.imag + step_imag * chirp.real;
+    step_real = next_step_real;
+    step_imag = next_step_imag;
+  }
+  phasor = {real, imag};
+  step = {step_real, step_imag};
+}
+
+/**
+ * @brief Render a linear chirp with a rotating phasor instead of calling
+ * sin() for every sample. The phase increment itself rotates by a constant
+ * amount each sample. The phasor is started from the exact phase, callers
+ * keep blocks short and restart it so float rounding does not accumulate.
+ *
+ * @param output - The buffer to render into.
+ * @param num_samples - The number of samples to render.
+ * @param angle - The phase before the first sample in radians.
+ * @param d_angle - The phase increment of the first sample in radians.
+ * @param dd_angle - The change of the phase increment per sample.
+ */
+inline void renderChirp(float *output, uint32_t num_samples, double angle,
+                        double d_angle, double dd_angle) {
+  Phasor phasor = makePhasor(angle);
+  Phasor step = makePhasor(d_angle);
+  rotatePhasor(output, num_samples, phasor, step, makePhasor(dd_angle));
+}
+
+/**
+ * @brief Convert a block of floats in the range [-1, 1] to samples, clipping
+ * anything outside of that range.
+ *
+ * @param input - The samples to convert.
+ * @param output - The buffer to write the converted samples to.
+ * @param num_samples - The number of samples to convert.
+ * @param amplitude - A gain applied before clipping.
+ */
+inline void floatToSamples(const float *input, int16_t *output,
+                           uint32_t num_samples, double amplitude) {
+  const float scale = static_cast<float>(amplitude * MAX_SAMPLE_AMPLITUDE);
+  constexpr float kLimit = MAX_SAMPLE_AMPLITUDE;
+  for (uint32_t i = 0; i < num_samples; i++) {
+    output[i] = static_cast<int16_t>(
+        std::clamp(input[i] * scale, -kLimit, kLimit));
+  }
+}
+
+} // namespace wavgen
+
+#endif /* OSCILLATOR_HPP_ */
@@ -0,0 +1,305 @@
+/**
+ * @file overview.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief A min/max/RMS pyramid of a WAV file for drawing waveforms.
+ * @date 2023-10-07
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <thread>
+
+#include <sys/stat.h>
+
+#include "error.hpp"
+#include "file.hpp"
+#include "wav_gen.hpp"
+#include "wav_overview.hpp"
+
+namespace wavgen {
+
+namespace {
+
+const std::string kOverviewMagic = "WGOV";
+inline constexpr uint32_t kOverviewVersion = 2;
+
+inline constexpr uint32_t kLargestBucket = OVERVIEW_BUCKET_SIZES.back();
+
+/**
+ * @brief The size and modification time of a WAV file, saved in its sidecar
+ * to detect changes made to the file without updating the sidecar.
+ */
+struct WavStamp {
+  uint64_t file_size = 0;
+  int64_t modified_ns = 0;
+
+  bool operator==(const WavStamp &other) const {
+    return file_size == other.file_size && modified_ns == other.modified_ns;
+  }
+};
+
+/**
+ * @brief Get the stamp of a WAV file.
+ * @return bool - False if the file can not be read, errno is set.
+ */
+bool tryStampWav(const std::string &wav_path, WavStamp &stamp) {
+  struct stat info {};
+  if (::stat(wav_path.c_str(), &info) != 0) {
+    return false;
+  }
+  stamp.file_size = static_cast<uint64_t>(info.st_size);
+  stamp.modified_ns =
+      int64_t{info.st_mtim.tv_sec} * 1'000'000'000 + info.st_mtim.tv_nsec;
+  return true;
+}
+
+WavStamp stampWav(const std::string &wav_path) {
+  WavStamp stamp;
+  if (!tryStampWav(wav_path, stamp)) {
+    WAVGEN_THROW(std::runtime_error("Failed to stat " + wav_path + "."));
+  }
+  return stamp;
+}
+
+} // namespace
+
+Overview::Overview() {
+  static_assert(sizeof(Summary) == 8, "Summary is saved as is.");
+}
+
+void Overview::addSamples(const int16_t *samples, uint32_t num_samples) {
+  constexpr uint32_t kFinestBucket = OVERVIEW_BUCKET_SIZES.front();
+  while (num_samples > 0) {
+    const uint32_t count = std::min(
+        num_samples, kFinestBucket - num_samples_ % kFinestBucket);
+
+    // Summarize the run that falls in one bucket of the finest level, then
+    // merge it into the current bucket of every level.
+    int32_t min = INT16_MAX;
+    int32_t max = INT16_MIN;
+    int64_t sum_of_squares = 0;
+    for (uint32_t i = 0; i < count; i++) {
+      const int32_t sample = samples[i];
+      min = std::min(min, sample);
+      max = std::max(max, sample);
+      sum_of_squares += sample * sample;
+    }
+
+    for (size_t level = 0; level < levels_.size(); level++) {
+      if (num_samples_ % OVERVIEW_BUCKET_SIZES[level] == 0) {
+        levels_[level].emplace_back();
+      }
+      Summary &bucket = levels_[level].back();
+      bucket.min = static_cast<int16_t>(std::min<int32_t>(bucket.min, min));
+      bucket.max = static_cast<int16_t>(std::max<int32_t>(bucket.max, max));
+      bucket.sum_of_squares += static_cast<float>(sum_of_squares);
+    }
+
+    num_samples_ += count;
+    samples += count;
+    num_samples -= count;
+  }
+}
+
+std::vector<OverviewBucket> Overview::query(uint32_t first_sample,
+                                            uint32_t num_samples,
+                                            uint32_t num_pixels) const {
+  std::vector<OverviewBucket> pixels;
+  if (num_pixels == 0 || first_sample >= num_samples_) {
+    return pixels;
+  }
+  num_samples = std::min(num_samples, num_samples_ - first_sample);
+
+  // The coarsest level with at least one bucket per pixel, so a pixel
+  // merges fewer buckets than the ratio between two levels.
+  size_t level = 0;
+  while (level + 1 < levels_.size() &&
+         OVERVIEW_BUCKET_SIZES[level + 1] <=
+             uint64_t{num_samples} / num_pixels) {
+    level++;
+  }
+  const uint32_t bucket_size = OVERVIEW_BUCKET_SIZES[level];
+  const auto &buckets = levels_[level];
+
+  pixels.resize(num_pixels);
+  for (uint32_t pixel = 0; pixel < num_pixels; pixel++) {
+    const uint64_t start =
+        first_sample + uint64_t{num_samples} * pixel / num_pixels;
+    const uint64_t end = std::max(
+        start + 1, first_sample + uint64_t{num_samples} * (pixel + 1) /
+                                      num_pixels);
+
+    int16_t min = INT16_MAX;
+    int16_t max = INT16_MIN;
+    double sum_of_squares = 0.0;
+    uint64_t count = 0;
+    const uint64_t last = std::min<uint64_t>((end - 1) / bucket_size,
+                                             buckets.size() - 1);
+    for (uint64_t index = start / bucket_size; index <= last; index++) {
+      min = std::min(min, buckets[index].min);
+      max = std::max(max, buckets[index].max);
+      sum_of_squares += buckets[index].sum_of_squares;
+      count += std::min<uint64_t>(bucket_size,
+                                  num_samples_ - index * bucket_size);
+    }
+    pixels[pixel].min = min;
+    pixels[pixel].max = max;
+    pixels[pixel].rms = static_cast<float>(std::sqrt(sum_of_squares / count));
+  }
+  return pixels;
+}
+
+void Overview::saveSidecar(const std::string &wav_path) const {
+  if (!trySaveSidecar(wav_path)) {
+    WAVGEN_THROW(std::runtime_error("Failed to write overview."));
+  }
+}
+
+bool Overview::trySaveSidecar(const std::string &wav_path) const {
+  WavStamp stamp;
+  if (!tryStampWav(wav_path, stamp)) {
+    return false;
+  }
+  std::ofstream file(sidecarPath(wav_path), std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+  file.write(kOverviewMagic.data(), kOverviewMagic.size());
+  writeBytes<4>(file, kOverviewVersion);
+  writeBytes<4>(file, num_samples_);
+  file.write(reinterpret_cast<const char *>(&stamp.file_size),
+             sizeof(stamp.file_size));
+  file.write(reinterpret_cast<const char *>(&stamp.modified_ns),
+             sizeof(stamp.modified_ns));
+  for (const auto &level : levels_) {
+    file.write(reinterpret_cast<const char *>(level.data()),
+               static_cast<std::streamsize>(level.size() * sizeof(Summary)));
+  }
+  return static_cast<bool>(file);
+}
+
+Overview Overview::loadSidecar(const std::string &wav_path) {
+  std::ifstream file(sidecarPath(wav_path), std::ios::binary);
+  validateFileOpen(file);
+
+  std::string magic(kOverviewMagic.size(), '\0');
+  uint32_t version = 0;
+  WavStamp stamp;
+  Overview overview;
+  file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+  file.read(reinterpret_cast<char *>(&version), sizeof(version));
+  file.read(reinterpret_cast<char *>(&overview.num_samples_),
+            sizeof(overview.num_samples_));
+  file.read(reinterpret_cast<char *>(&stamp.file_size),
+            sizeof(stamp.file_size));
+  file.read(reinterpret_cast<char *>(&stamp.modified_ns),
+            sizeof(stamp.modified_ns));
+  if (!file || magic != kOverviewMagic || version != kOverviewVersion) {
+    WAVGEN_THROW(std::runtime_error("Not an overview file."));
+  }
+  if (!(stamp == stampWav(wav_path))) {
+    WAVGEN_THROW(std::runtime_error("The overview is out of date."));
+  }
+
+  for (size_t level = 0; level < overview.levels_.size(); level++) {
+    const uint32_t bucket_size = OVERVIEW_BUCKET_SIZES[level];
+    overview.levels_[level].resize(
+        (uint64_t{overview.num_samples_} + bucket_size - 1) / bucket_size);
+    file.read(reinterpret_cast<char *>(overview.levels_[level].data()),
+              static_cast<std::streamsize>(overview.levels_[level].size() *
+                                           sizeof(Summary)));
+  }
+  if (!file) {
+    WAVGEN_THROW(std::runtime_error("Overview file is too short."));
+  }
+  return overview;
+}
+
+void Overview::removeSidecar(const std::string &wav_path) {
+  if (::unlink(sidecarPath(wav_path).c_str()) != 0 && errno != ENOENT) {
+    WAVGEN_THROW(std::runtime_error("Failed to remove overview."));
+  }
+}
+
+Overview Overview::build(const std::string &wav_path, uint32_t num_threads) {
+  const FileDescriptor file = openFile(wav_path, O_RDONLY);
+  const WavLayout layout = readLayout(file.get(), calculateFileSize(file));
+  if (layout.format.sample_format != SampleFormat::PCM_16 ||
+      layout.format.num_channels != 1) {
+    WAVGEN_THROW(std::runtime_error("An overview needs a 16-bit mono file."));
+  }
+  const uint32_t num_samples = layout.data_size / sizeof(int16_t);
+
+  // Each thread summarizes a range that starts on a bucket of every level,
+  // so the results can simply be appended.
+  const uint32_t num_units =
+      static_cast<uint32_t>((uint64_t{num_samples} + kLargestBucket - 1) /
+                            kLargestBucket);
+  if (num_threads == 0) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  num_threads = std::max(1U, std::min(num_threads, num_units));
+
+  std::vector<Overview> parts(num_threads);
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto work = [&](uint32_t part) {
+#ifndef WAVGEN_NO_EXCEPTIONS
+    try {
+#endif
+      const uint64_t first_unit = uint64_t{num_units} * part / num_threads;
+      const uint64_t last_unit = uint64_t{num_units} * (part + 1) / num_threads;
+      std::vector<int16_t> block(kLargestBucket);
+      for (uint64_t unit = first_unit; unit < last_unit; unit++) {
+        const uint64_t first = unit * kLargestBucket;
+        const uint32_t count = static_cast<uint32_t>(
+            std::min<uint64_t>(kLargestBucket, num_samples - first));
+        readAt(file, block.data(), count * sizeof(int16_t),
+               layout.data_offset + first * sizeof(int16_t));
+        parts[part].addSamples(block.data(), count);
+      }
+#ifndef WAVGEN_NO_EXCEPTIONS
+    } catch (...) {
+      errors[part] = std::current_exception();
+    }
+#endif
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t part = 1; part < num_threads; part++) {
+    threads.emplace_back(work, part);
+  }
+  work(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+#ifndef WAVGEN_NO_EXCEPTIONS
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+#endif
+
+  Overview overview;
+  for (const auto &part : parts) {
+    overview.append(part);
+  }
+  return overview;
+}
+
+void Overview::append(const Overview &other) {
+  if (num_samples_ % kLargestBucket != 0) {
+    WAVGEN_THROW(
+        std::runtime_error("Overview does not end on a bucket boundary."));
+  }
+  for (size_t level = 0; level < levels_.size(); level++) {
+    levels_[level].insert(levels_[level].end(), other.levels_[level].begin(),
+                          other.levels_[level].end());
+  }
+  num_samples_ += other.num_samples_;
+}
+
+} // namespace wavgen
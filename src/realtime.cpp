@@ -0,0 +1,202 @@
+/**
+ * @file realtime.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief A pull based generator for real-time audio output.
+ * @date 2023-08-12
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "oscillator.hpp"
+#include "ring_buffer.hpp"
+#include "wav_realtime.hpp"
+
+namespace wavgen {
+
+namespace {
+/**
+ * @brief How long the recording thread sleeps when there is nothing to write.
+ */
+inline constexpr std::chrono::milliseconds kRecordingPollInterval{2};
+} // namespace
+
+RealtimeGenerator::RealtimeGenerator(uint32_t command_queue_size)
+    : commands_(std::make_unique<RingBuffer<Command>>(command_queue_size)),
+      recording_buffer_(nullptr) {
+}
+
+RealtimeGenerator::~RealtimeGenerator() {
+  stopRecording();
+}
+
+bool RealtimeGenerator::queueSineWave(double frequency, double amplitude,
+                                      uint32_t samples) {
+  Command command;
+  command.d_angle = kTwoPi * frequency / SAMPLE_RATE;
+  command.amplitude = amplitude;
+  command.samples = samples;
+
+  // Count the samples before the audio thread can see the command, it
+  // subtracts them as they are rendered.
+  queued_samples_.fetch_add(samples, std::memory_order_relaxed);
+  if (!commands_->push(command)) {
+    queued_samples_.fetch_sub(samples, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool RealtimeGenerator::queueSilence(uint32_t samples) {
+  return queueSineWave(0.0, 0.0, samples);
+}
+
+uint64_t RealtimeGenerator::getQueuedSamples() const {
+  return queued_samples_.load(std::memory_order_relaxed);
+}
+
+void RealtimeGenerator::render(int16_t *block, uint32_t num_samples) {
+  const auto start = std::chrono::steady_clock::now();
+
+  // Reset here when asked to, so this thread is the only one that writes
+  // the statistics.
+  if (reset_stats_.load(std::memory_order_relaxed) &&
+      reset_stats_.exchange(false, std::memory_order_acquire)) {
+    blocks_rendered_.store(0, std::memory_order_relaxed);
+    samples_rendered_.store(0, std::memory_order_relaxed);
+    underrun_samples_.store(0, std::memory_order_relaxed);
+    dropped_recording_samples_.store(0, std::memory_order_relaxed);
+    last_render_ns_.store(0, std::memory_order_relaxed);
+    worst_render_ns_.store(0, std::memory_order_relaxed);
+    total_render_ns_.store(0, std::memory_order_relaxed);
+  }
+
+  uint32_t rendered = 0;
+  uint64_t underrun = 0;
+  while (rendered < num_samples) {
+    if (current_.samples == 0 && !commands_->pop(current_)) {
+      // Nothing queued, fill the rest of the block with silence.
+      underrun = num_samples - rendered;
+      std::memset(block + rendered, 0, underrun * sizeof(int16_t));
+      break;
+    }
+
+    const uint32_t count = std::min(current_.samples, num_samples - rendered);
+    renderSine(block + rendered, count, current_.d_angle, current_.amplitude,
+               wave_angle_);
+    current_.samples -= count;
+    rendered += count;
+    queued_samples_.fetch_sub(count, std::memory_order_relaxed);
+  }
+
+  // Announce the push before checking the flag, stopRecording() clears the
+  // flag and then waits for this one, so a block is either pushed before
+  // the final drain or not at all.
+  rendering_.store(true, std::memory_order_seq_cst);
+  if (recording_.load(std::memory_order_seq_cst)) {
+    const size_t pushed = recording_buffer_->push(block, num_samples);
+    if (pushed < num_samples) {
+      dropped_recording_samples_.fetch_add(num_samples - pushed,
+                                           std::memory_order_relaxed);
+    }
+  }
+  rendering_.store(false, std::memory_order_release);
+
+  const int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+  blocks_rendered_.fetch_add(1, std::memory_order_relaxed);
+  samples_rendered_.fetch_add(num_samples, std::memory_order_relaxed);
+  underrun_samples_.fetch_add(underrun, std::memory_order_relaxed);
+  last_render_ns_.store(elapsed, std::memory_order_relaxed);
+  total_render_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+  if (elapsed > worst_render_ns_.load(std::memory_order_relaxed)) {
+    worst_render_ns_.store(elapsed, std::memory_order_relaxed);
+  }
+}
+
+void RealtimeGenerator::renderCallback(void *user_data, int16_t *block,
+                                       uint32_t num_samples) {
+  static_cast<RealtimeGenerator *>(user_data)->render(block, num_samples);
+}
+
+void RealtimeGenerator::startRecording(Writer &writer, uint32_t buffer_size) {
+  stopRecording();
+
+  // render() does not touch the buffer while not recording, so it can be
+  // replaced here. The capacity is buffer_size rounded up to a power of two.
+  if (recording_buffer_ == nullptr ||
+      buffer_size > recording_buffer_->capacity() ||
+      buffer_size <= recording_buffer_->capacity() / 2) {
+    recording_buffer_ = std::make_unique<RingBuffer<int16_t>>(buffer_size);
+  }
+
+  // Discard anything left over from a previous recording.
+  std::array<int16_t, kRenderBlockSize> discard;
+  while (recording_buffer_->pop(discard.data(), discard.size()) > 0) {
+  }
+
+  recording_writer_ = &writer;
+  stop_recording_thread_.store(false, std::memory_order_relaxed);
+  recording_.store(true, std::memory_order_seq_cst);
+  recording_thread_ = std::thread(&RealtimeGenerator::recordingLoop, this);
+}
+
+void RealtimeGenerator::stopRecording() {
+  if (!recording_thread_.joinable()) {
+    return;
+  }
+  recording_.store(false, std::memory_order_seq_cst);
+
+  // A render() that saw the flag still set may be pushing a block, wait for
+  // it before the recording thread does its final drain.
+  while (rendering_.load(std::memory_order_seq_cst)) {
+    std::this_thread::yield();
+  }
+  stop_recording_thread_.store(true, std::memory_order_release);
+  recording_thread_.join();
+  recording_writer_ = nullptr;
+}
+
+void RealtimeGenerator::recordingLoop() {
+  std::array<int16_t, WRITER_BUFFER_SIZE> block;
+  while (true) {
+    // Read the flag before draining so the last samples pushed before
+    // stopRecording() are always written.
+    const bool recording =
+        !stop_recording_thread_.load(std::memory_order_acquire);
+    size_t count = 0;
+    while ((count = recording_buffer_->pop(block.data(), block.size())) > 0) {
+      recording_writer_->addSamples(block.data(),
+                                    static_cast<uint32_t>(count));
+    }
+    if (!recording) {
+      return;
+    }
+    std::this_thread::sleep_for(kRecordingPollInterval);
+  }
+}
+
+RealtimeGenerator::Stats RealtimeGenerator::getStats() const {
+  Stats stats;
+  stats.blocks_rendered = blocks_rendered_.load(std::memory_order_relaxed);
+  stats.samples_rendered = samples_rendered_.load(std::memory_order_relaxed);
+  stats.underrun_samples = underrun_samples_.load(std::memory_order_relaxed);
+  stats.dropped_recording_samples =
+      dropped_recording_samples_.load(std::memory_order_relaxed);
+  stats.last_render_time =
+      std::chrono::nanoseconds(last_render_ns_.load(std::memory_order_relaxed));
+  stats.worst_render_time = std::chrono::nanoseconds(
+      worst_render_ns_.load(std::memory_order_relaxed));
+  stats.total_render_time = std::chrono::nanoseconds(
+      total_render_ns_.load(std::memory_order_relaxed));
+  return stats;
+}
+
+void RealtimeGenerator::resetStats() {
+  reset_stats_.store(true, std::memory_order_release);
+}
+
+} // namespace wavgen
@@ -0,0 +1,65 @@
+/**
+ * @file recover.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Repair the header of an unfinished WAV file.
+ * @date 2023-09-16
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <array>
+
+#include "file.hpp"
+#include "wav_gen.hpp"
+#include "wav_tools.hpp"
+
+namespace wavgen {
+
+RecoverResult recoverFile(const std::string &file_path) {
+  const FileDescriptor file = openFile(file_path, O_RDWR);
+  uint64_t file_size = calculateFileSize(file);
+  if (file_size < HEADER_SIZE) {
+    throw std::runtime_error("File is too short to be a WAV file.");
+  }
+
+  // Validates the format fields, the sizes are expected to be stale. Only
+  // the layout written by Writer can be recovered by rewriting its header.
+  const WavLayout layout =
+      readLayout(file.get(), file_size, /*check_data_size=*/false);
+  if (layout.format.sample_format != SampleFormat::PCM_16 ||
+      layout.format.sample_rate != SAMPLE_RATE ||
+      layout.data_offset != HEADER_SIZE) {
+    throw std::runtime_error("Only files written by Writer can be recovered.");
+  }
+
+  // Keep whole frames only, and no more than the header can describe.
+  const uint64_t block_align = layout.block_align;
+  const uint64_t max_data_size =
+      (UINT32_MAX - HEADER_SIZE) / block_align * block_align;
+  const uint64_t data_size = std::min(
+      (file_size - HEADER_SIZE) / block_align * block_align, max_data_size);
+  const auto recovered = packHeader(makeHeader(
+      static_cast<uint32_t>(data_size), layout.format.num_channels));
+  std::array<char, HEADER_SIZE> current{};
+  readAt(file, current.data(), current.size(), 0);
+
+  RecoverResult result;
+  result.num_samples = static_cast<uint32_t>(data_size / block_align);
+  result.bytes_truncated =
+      static_cast<uint32_t>(file_size - HEADER_SIZE - data_size);
+  result.was_consistent = result.bytes_truncated == 0 && current == recovered;
+  if (result.was_consistent) {
+    return result;
+  }
+
+  if (result.bytes_truncated > 0 &&
+      ::ftruncate(file.get(), static_cast<off_t>(HEADER_SIZE + data_size)) !=
+          0) {
+    throw std::runtime_error("Failed to truncate file.");
+  }
+
+  writeAt(file, recovered.data(), recovered.size(), 0);
+  return result;
+}
+
+} // namespace wavgen
@@ -0,0 +1,111 @@
+/**
+ * @file ring_buffer.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief A lock-free single producer, single consumer ring buffer.
+ * @date 2023-08-12
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef RING_BUFFER_HPP_
+#define RING_BUFFER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "error.hpp"
+
+namespace wavgen {
+
+/**
+ * @brief A bounded, wait-free ring buffer for exactly one producer thread and
+ * one consumer thread. The storage is allocated at construction, push and pop
+ * never allocate or block.
+ *
+ * @tparam T - The element type, should be trivially copyable.
+ */
+template <typename T> class RingBuffer {
+public:
+  /**
+   * @param capacity - The number of elements, rounded up to a power of two.
+   */
+  explicit RingBuffer(size_t capacity) : buffer_(roundUp(capacity)) {
+    mask_ = buffer_.size() - 1;
+  }
+
+  size_t capacity() const {
+    return buffer_.size();
+  }
+
+  /**
+   * @brief Number of elements that can currently be popped.
+   */
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Push up to count elements (producer only).
+   * @return size_t - The number of elements pushed.
+   */
+  size_t push(const T *items, size_t count) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    count = std::min(count, buffer_.size() - (tail - head));
+    for (size_t i = 0; i < count; i++) {
+      buffer_[(tail + i) & mask_] = items[i];
+    }
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  bool push(const T &item) {
+    return push(&item, 1) == 1;
+  }
+
+  /**
+   * @brief Pop up to count elements (consumer only).
+   * @return size_t - The number of elements popped.
+   */
+  size_t pop(T *items, size_t count) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    count = std::min(count, tail - head);
+    for (size_t i = 0; i < count; i++) {
+      items[i] = buffer_[(head + i) & mask_];
+    }
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  bool pop(T &item) {
+    return pop(&item, 1) == 1;
+  }
+
+private:
+  static size_t roundUp(size_t capacity) {
+    if (capacity == 0) {
+      WAVGEN_THROW(
+          std::runtime_error("Ring buffer capacity must not be zero."));
+    }
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  std::vector<T> buffer_;
+  size_t mask_ = 0;
+
+  // Kept on separate cache lines so the two threads do not share one.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+} // namespace wavgen
+
+#endif /* RING_BUFFER_HPP_ */
@@ -0,0 +1,310 @@
+/**
+ * @file sstv.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Slow scan television (SSTV) image encoding.
+ * @date 2023-10-21
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "error.hpp"
+#include "oscillator.hpp"
+#include "wav_sstv.hpp"
+
+namespace wavgen {
+
+namespace {
+
+inline constexpr uint64_t kNanoseconds = 1'000'000'000;
+inline constexpr uint64_t kMs = 1'000'000;
+
+// Pixel levels 0 - 255 are 1500 - 2300 Hz, so black is also the 1500 Hz
+// porch and separator tone. The others follow the pixel levels in steps_.
+inline constexpr uint16_t kBlack = 0;
+inline constexpr uint16_t kWhite = 255;
+inline constexpr uint16_t kVisOne = 256;   // 1100 Hz
+inline constexpr uint16_t kSync = 257;     // 1200 Hz
+inline constexpr uint16_t kVisZero = 258;  // 1300 Hz
+inline constexpr uint16_t kLeader = 259;   // 1900 Hz
+
+inline constexpr uint64_t kLeaderNs = 300 * kMs;
+inline constexpr uint64_t kBreakNs = 10 * kMs;
+inline constexpr uint64_t kVisBitNs = 30 * kMs;
+
+/**
+ * @brief The timing of a mode in nanoseconds. Robot modes have half
+ * horizontal resolution colour difference scans after the luminance scan.
+ */
+struct ModeTiming {
+  uint8_t vis_code;
+  uint16_t width;
+  uint16_t height;
+  uint64_t sync_ns;
+  uint64_t porch_ns;
+  uint64_t separator_ns;
+  uint64_t pixel_ns;
+  uint64_t chroma_porch_ns;
+  uint64_t chroma_pixel_ns;
+};
+
+// In the order of SstvMode.
+inline constexpr std::array<ModeTiming, 6> kModes = {{
+    {8, 320, 240, 9 * kMs, 3 * kMs, 4'500'000, 275'000, 1'500'000, 275'000},
+    {12, 320, 240, 9 * kMs, 3 * kMs, 4'500'000, 431'250, 1'500'000, 431'250},
+    {44, 320, 256, 4'862'000, 572'000, 572'000, 457'600, 0, 0},
+    {40, 320, 256, 4'862'000, 572'000, 572'000, 228'800, 0, 0},
+    {60, 320, 256, 9 * kMs, 1'500'000, 1'500'000, 432'000, 0, 0},
+    {56, 320, 256, 9 * kMs, 1'500'000, 1'500'000, 275'200, 0, 0},
+}};
+
+const ModeTiming &getTiming(SstvMode mode) {
+  return kModes[static_cast<size_t>(mode)];
+}
+
+uint64_t getLineNs(SstvMode mode) {
+  const ModeTiming &timing = getTiming(mode);
+  const uint64_t scan_ns = timing.width * timing.pixel_ns;
+  const uint64_t chroma_ns = timing.chroma_porch_ns + timing.separator_ns +
+                             timing.width / 2 * timing.chroma_pixel_ns;
+  switch (mode) {
+  case SstvMode::ROBOT_36:
+    return timing.sync_ns + timing.porch_ns + scan_ns + chroma_ns;
+  case SstvMode::ROBOT_72:
+    return timing.sync_ns + timing.porch_ns + scan_ns + 2 * chroma_ns;
+  case SstvMode::MARTIN_1:
+  case SstvMode::MARTIN_2:
+    return timing.sync_ns + timing.porch_ns +
+           3 * (scan_ns + timing.separator_ns);
+  case SstvMode::SCOTTIE_1:
+  case SstvMode::SCOTTIE_2:
+    return 2 * (timing.separator_ns + scan_ns) + timing.sync_ns +
+           timing.porch_ns + scan_ns;
+  }
+  return 0;
+}
+
+/**
+ * @brief Round a time since the start of the transmission to the nearest
+ * sample.
+ */
+uint64_t toSamples(uint64_t time_ns) {
+  return (2 * time_ns * SAMPLE_RATE + kNanoseconds) / (2 * kNanoseconds);
+}
+
+uint8_t toLevel(double value) {
+  return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L));
+}
+
+} // namespace
+
+SstvModeInfo getSstvModeInfo(SstvMode mode) {
+  const ModeTiming &timing = getTiming(mode);
+  const uint64_t line_ns = getLineNs(mode);
+  const uint64_t divisor = std::gcd(line_ns, kNanoseconds);
+
+  SstvModeInfo info;
+  info.vis_code = timing.vis_code;
+  info.width = timing.width;
+  info.height = timing.height;
+  info.line_duration = Duration::seconds(line_ns / divisor,
+                                         kNanoseconds / divisor);
+  return info;
+}
+
+SstvEncoder::SstvEncoder(SstvMode mode, double amplitude)
+    : mode_(mode), info_(getSstvModeInfo(mode)), amplitude_(amplitude) {
+  for (uint16_t level = 0; level <= kWhite; level++) {
+    steps_[level].d_angle = kTwoPi * (1500.0 + 800.0 * level / 255.0) /
+                            SAMPLE_RATE;
+  }
+  steps_[kVisOne].d_angle = kTwoPi * 1100.0 / SAMPLE_RATE;
+  steps_[kSync].d_angle = kTwoPi * 1200.0 / SAMPLE_RATE;
+  steps_[kVisZero].d_angle = kTwoPi * 1300.0 / SAMPLE_RATE;
+  steps_[kLeader].d_angle = kTwoPi * 1900.0 / SAMPLE_RATE;
+  for (Step &step : steps_) {
+    step.real = static_cast<float>(std::cos(step.d_angle));
+    step.imag = static_cast<float>(std::sin(step.d_angle));
+  }
+
+  // Size the buffers for the longest block up front, the header or the first
+  // line of a Scottie mode, so encoding does not allocate.
+  const uint64_t header_ns = 2 * kLeaderNs + kBreakNs + 10 * kVisBitNs;
+  const uint64_t line_ns = getLineNs(mode) + getTiming(mode).sync_ns;
+  const size_t max_samples = toSamples(std::max(header_ns, line_ns)) + 1;
+  wave_.resize(max_samples);
+  samples_.resize(max_samples);
+  runs_.reserve(3 * info_.width + 16);
+  levels_.resize(2 * info_.width);
+}
+
+void SstvEncoder::addHeader(Writer &writer) {
+  addTone(kLeader, kLeaderNs);
+  addTone(kSync, kBreakNs);
+  addTone(kLeader, kLeaderNs);
+
+  // Start bit, 7 bits least significant first, even parity and stop bit.
+  addTone(kSync, kVisBitNs);
+  bool parity = false;
+  for (int bit = 0; bit < 7; bit++) {
+    const bool one = (info_.vis_code >> bit) & 1;
+    parity ^= one;
+    addTone(one ? kVisOne : kVisZero, kVisBitNs);
+  }
+  addTone(parity ? kVisOne : kVisZero, kVisBitNs);
+  addTone(kSync, kVisBitNs);
+
+  line_ = 0;
+  render(writer);
+}
+
+void SstvEncoder::addLine(Writer &writer, const uint8_t *rgb) {
+  if (line_ >= info_.height) {
+    WAVGEN_THROW(std::runtime_error("The SSTV image has no lines left."));
+  }
+
+  const ModeTiming &timing = getTiming(mode_);
+  constexpr size_t kRed = 0;
+  constexpr size_t kGreen = 1;
+  constexpr size_t kBlue = 2;
+  switch (mode_) {
+  case SstvMode::ROBOT_36:
+  case SstvMode::ROBOT_72:
+    addRobotLine(rgb);
+    break;
+  case SstvMode::MARTIN_1:
+  case SstvMode::MARTIN_2:
+    addTone(kSync, timing.sync_ns);
+    addTone(kBlack, timing.porch_ns);
+    for (size_t channel : {kGreen, kBlue, kRed}) {
+      addScan(rgb + channel, 3, info_.width, timing.pixel_ns);
+      addTone(kBlack, timing.separator_ns);
+    }
+    break;
+  case SstvMode::SCOTTIE_1:
+  case SstvMode::SCOTTIE_2:
+    // The sync pulse is in the middle of the line, so the first line is
+    // preceded by an extra one.
+    if (line_ == 0) {
+      addTone(kSync, timing.sync_ns);
+    }
+    addTone(kBlack, timing.separator_ns);
+    addScan(rgb + kGreen, 3, info_.width, timing.pixel_ns);
+    addTone(kBlack, timing.separator_ns);
+    addScan(rgb + kBlue, 3, info_.width, timing.pixel_ns);
+    addTone(kSync, timing.sync_ns);
+    addTone(kBlack, timing.porch_ns);
+    addScan(rgb + kRed, 3, info_.width, timing.pixel_ns);
+    break;
+  }
+
+  line_++;
+  render(writer);
+}
+
+void SstvEncoder::addImage(Writer &writer, const uint8_t *rgb, size_t size) {
+  const size_t line_size = size_t{info_.width} * 3;
+  if (size != line_size * info_.height) {
+    WAVGEN_THROW(std::runtime_error("The image size does not match the SSTV "
+                                    "mode."));
+  }
+
+  addHeader(writer);
+  for (uint16_t row = 0; row < info_.height; row++) {
+    addLine(writer, rgb + row * line_size);
+  }
+}
+
+void SstvEncoder::addTone(uint16_t tone, uint64_t duration_ns) {
+  time_ns_ += duration_ns;
+  const uint64_t end_sample = toSamples(time_ns_);
+  runs_.push_back({static_cast<uint32_t>(end_sample - num_samples_), tone});
+  num_samples_ = end_sample;
+}
+
+void SstvEncoder::addScan(const uint8_t *levels, size_t stride,
+                          uint16_t num_pixels, uint64_t pixel_ns) {
+  for (uint16_t i = 0; i < num_pixels; i++) {
+    addTone(levels[i * stride], pixel_ns);
+  }
+}
+
+void SstvEncoder::addRobotLine(const uint8_t *rgb) {
+  // Luminance at full resolution, the colour differences of pixel pairs.
+  const uint16_t chroma_width = info_.width / 2;
+  uint8_t *luma = levels_.data();
+  uint8_t *red_difference = luma + info_.width;
+  uint8_t *blue_difference = red_difference + chroma_width;
+  for (uint16_t i = 0; i < info_.width; i++) {
+    const uint8_t *pixel = rgb + i * 3;
+    luma[i] = toLevel(16.0 + (65.738 * pixel[0] + 129.057 * pixel[1] +
+                              25.064 * pixel[2]) / 256.0);
+  }
+  for (uint16_t i = 0; i < chroma_width; i++) {
+    const uint8_t *pair = rgb + i * 6;
+    const double red = (pair[0] + pair[3]) / 2.0;
+    const double green = (pair[1] + pair[4]) / 2.0;
+    const double blue = (pair[2] + pair[5]) / 2.0;
+    red_difference[i] = toLevel(
+        128.0 + (112.439 * red - 94.154 * green - 18.285 * blue) / 256.0);
+    blue_difference[i] = toLevel(
+        128.0 + (-37.945 * red - 74.494 * green + 112.439 * blue) / 256.0);
+  }
+
+  const ModeTiming &timing = getTiming(mode_);
+  addTone(kSync, timing.sync_ns);
+  addTone(kBlack, timing.porch_ns);
+  addScan(luma, 1, info_.width, timing.pixel_ns);
+
+  // The separator tone tells the decoder which difference follows. Robot 36
+  // alternates between them from line to line, Robot 72 sends both.
+  const bool both = mode_ == SstvMode::ROBOT_72;
+  if (both || line_ % 2 == 0) {
+    addTone(kBlack, timing.separator_ns);
+    addTone(kLeader, timing.chroma_porch_ns);
+    addScan(red_difference, 1, chroma_width, timing.chroma_pixel_ns);
+  }
+  if (both || line_ % 2 == 1) {
+    addTone(kWhite, timing.separator_ns);
+    addTone(kLeader, timing.chroma_porch_ns);
+    addScan(blue_difference, 1, chroma_width, timing.chroma_pixel_ns);
+  }
+}
+
+void SstvEncoder::render(Writer &writer) {
+  // One rotating phasor over all of the runs, with the cached step of each
+  // tone. It is restarted from the exact phase every kRenderBlockSize
+  // samples so float rounding can not accumulate over the line.
+  Phasor phasor;
+  uint32_t since_restart = kRenderBlockSize;
+  size_t position = 0;
+  for (const Run &run : runs_) {
+    const Step &step = steps_[run.tone];
+    uint32_t remaining = run.num_samples;
+    while (remaining > 0) {
+      if (since_restart == kRenderBlockSize) {
+        phasor = makePhasor(angle_);
+        since_restart = 0;
+      }
+      const uint32_t count =
+          std::min(remaining, kRenderBlockSize - since_restart);
+      Phasor rotation{step.real, step.imag};
+      rotatePhasor(wave_.data() + position, count, phasor, rotation,
+                   Phasor{});
+      angle_ = std::fmod(angle_ + step.d_angle * count, kTwoPi);
+      position += count;
+      since_restart += count;
+      remaining -= count;
+    }
+  }
+  runs_.clear();
+
+  const auto num_samples = static_cast<uint32_t>(position);
+  floatToSamples(wave_.data(), samples_.data(), num_samples, amplitude_);
+  writer.addSamples(samples_.data(), num_samples);
+}
+
+} // namespace wavgen
@@ -0,0 +1,106 @@
+/**
+ * @file timeline.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Sample accurate schedules of tones and silence.
+ * @date 2023-10-14
+ * @copyright Copyright (c) 2023
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "error.hpp"
+#include "oscillator.hpp"
+#include "wav_timeline.hpp"
+
+namespace wavgen {
+
+void Timeline::addTone(double frequency, double amplitude,
+                       Duration duration) {
+  Segment segment;
+  segment.end_sample = advance(duration);
+  segment.d_angle = kTwoPi * frequency / SAMPLE_RATE;
+  segment.amplitude = amplitude;
+  segment.silent = false;
+  segments_.push_back(segment);
+}
+
+void Timeline::addSilence(Duration duration) {
+  Segment segment;
+  segment.end_sample = advance(duration);
+  segments_.push_back(segment);
+}
+
+uint64_t Timeline::getNumSamples() const {
+  return segments_.empty() ? 0 : segments_.back().end_sample;
+}
+
+uint64_t Timeline::advance(Duration duration) {
+  if (duration.denominator == 0) {
+    WAVGEN_THROW(std::runtime_error("A duration needs a denominator above 0."));
+  }
+
+  // cursor + duration in lowest terms.
+  const uint64_t divisor = std::gcd(cursor_.denominator, duration.denominator);
+  const uint64_t scale = duration.denominator / divisor;
+  cursor_.numerator = cursor_.numerator * scale +
+                      duration.numerator * (cursor_.denominator / divisor);
+  cursor_.denominator *= scale;
+  const uint64_t common = std::gcd(cursor_.numerator, cursor_.denominator);
+  if (common > 1) {
+    cursor_.numerator /= common;
+    cursor_.denominator /= common;
+  }
+
+  // Round the exact time to the nearest sample.
+  return (2 * cursor_.numerator * SAMPLE_RATE + cursor_.denominator) /
+         (2 * cursor_.denominator);
+}
+
+uint32_t Timeline::render(int16_t *output, uint32_t num_samples) {
+  std::array<float, kRenderBlockSize> wave;
+  uint32_t rendered = 0;
+  while (rendered < num_samples && segment_ < segments_.size()) {
+    const Segment &segment = segments_[segment_];
+    const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(
+        {segment.end_sample - position_, num_samples - rendered,
+         kRenderBlockSize}));
+
+    if (!segment.silent) {
+      renderChirp(wave.data(), count, angle_, segment.d_angle, 0.0);
+      floatToSamples(wave.data(), output + rendered, count,
+                     segment.amplitude);
+      angle_ = std::fmod(angle_ + segment.d_angle * count, kTwoPi);
+    } else {
+      std::fill_n(output + rendered, count, 0);
+    }
+
+    rendered += count;
+    position_ += count;
+    if (position_ == segment.end_sample) {
+      segment_++;
+    }
+  }
+  return rendered;
+}
+
+void Timeline::renderTo(Writer &writer) {
+  std::array<int16_t, kRenderBlockSize> block;
+  uint32_t count = 0;
+  while ((count = render(block.data(), kRenderBlockSize)) > 0) {
+    writer.addSamples(block.data(), count);
+  }
+}
+
+void Timeline::clear() {
+  segments_.clear();
+  cursor_ = Duration();
+  position_ = 0;
+  segment_ = 0;
+  angle_ = 0.0;
+}
+
+} // namespace wavgen
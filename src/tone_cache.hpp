@@ -0,0 +1,147 @@
+/**
+ * @file tone_cache.hpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief A memory bounded LRU cache of rendered tone segments.
+ * @date 2023-08-26
+ * @copyright Copyright (c) 2023
+ */
+
+#ifndef TONE_CACHE_HPP_
+#define TONE_CACHE_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "wav_gen.hpp"
+
+namespace wavgen {
+
+/**
+ * @brief Caches rendered segments keyed by their parameters and (quantized)
+ * starting phase. The least recently used segments are evicted to stay
+ * under the memory limit.
+ */
+class ToneCache {
+public:
+  /**
+   * @brief The number of starting phases a segment can be cached for.
+   */
+  static constexpr uint32_t kPhaseSteps = 4096;
+
+  enum class Kind : uint8_t { SINE_WAVE, SINE_WAVE_SAMPLES };
+
+  struct Key {
+    Kind kind = Kind::SINE_WAVE;
+    uint16_t frequency = 0;
+    uint64_t amplitude_bits = 0;
+    uint32_t samples = 0;
+    uint32_t phase_index = 0;
+
+    bool operator==(const Key &other) const {
+      return kind == other.kind && frequency == other.frequency &&
+             amplitude_bits == other.amplitude_bits &&
+             samples == other.samples && phase_index == other.phase_index;
+    }
+  };
+
+  struct Entry {
+    std::vector<int16_t> samples{};
+
+    /**
+     * @brief The phase of the oscillator after the segment.
+     */
+    double end_angle = 0.0;
+  };
+
+  static Key makeKey(Kind kind, uint16_t frequency, double amplitude,
+                     uint32_t samples, uint32_t phase_index) {
+    Key key;
+    key.kind = kind;
+    key.frequency = frequency;
+    std::memcpy(&key.amplitude_bits, &amplitude, sizeof(amplitude));
+    key.samples = samples;
+    key.phase_index = phase_index;
+    return key;
+  }
+
+  explicit ToneCache(size_t max_bytes) : max_bytes_(max_bytes) {
+  }
+
+  /**
+   * @brief Look up a segment, counting a hit or a miss.
+   * @return const Entry* - The segment, or nullptr if it is not cached.
+   */
+  const Entry *find(const Key &key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      stats_.misses++;
+      return nullptr;
+    }
+    stats_.hits++;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  /**
+   * @brief Store a segment. Segments larger than the whole cache are not
+   * stored.
+   */
+  void insert(const Key &key, Entry entry) {
+    const size_t bytes = entrySize(entry);
+    if (bytes > max_bytes_ || index_.count(key) != 0) {
+      return;
+    }
+
+    while (stats_.bytes + bytes > max_bytes_ && !entries_.empty()) {
+      auto &oldest = entries_.back();
+      stats_.bytes -= entrySize(oldest.second);
+      index_.erase(oldest.first);
+      entries_.pop_back();
+      stats_.evictions++;
+    }
+
+    entries_.emplace_front(key, std::move(entry));
+    index_[key] = entries_.begin();
+    stats_.bytes += bytes;
+    stats_.entries = entries_.size();
+  }
+
+  size_t getMaxBytes() const {
+    return max_bytes_;
+  }
+
+  ToneCacheStats getStats() const {
+    ToneCacheStats stats = stats_;
+    stats.entries = entries_.size();
+    return stats;
+  }
+
+private:
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      uint64_t hash = key.amplitude_bits;
+      hash = hash * 31 + static_cast<uint64_t>(key.kind);
+      hash = hash * 31 + key.frequency;
+      hash = hash * 31 + key.samples;
+      hash = hash * 31 + key.phase_index;
+      return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+  };
+
+  static size_t entrySize(const Entry &entry) {
+    return entry.samples.size() * sizeof(int16_t);
+  }
+
+  size_t max_bytes_;
+  std::list<std::pair<Key, Entry>> entries_{};
+  std::unordered_map<Key, std::list<std::pair<Key, Entry>>::iterator, KeyHash>
+      index_{};
+  ToneCacheStats stats_{};
+};
+
+} // namespace wavgen
+
+#endif /* TONE_CACHE_HPP_ */
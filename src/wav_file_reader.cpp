@@ -6,52 +6,235 @@
  * @copyright Copyright (c) 2023
  */
 
+#include <algorithm>
 #include <cstdint>
+#include <type_traits>
 
+#include "convert.hpp"
 #include "file.hpp"
+#include "interleave.hpp"
+#include "wav_filter.hpp"
 #include "wav_gen.hpp"
+#include "wav_overview.hpp"
 
 namespace wavgen {
 
 Reader::Reader(std::string input_file_path) {
-  wav_file_.open(input_file_path, std::ios::binary);
-  validateFileOpen(wav_file_);
-
-  WavHeader header;
-  wav_file_ >> header; // Read the header from the file
+  FileDescriptor file = openFile(input_file_path, O_RDONLY);
+  const WavLayout layout = readLayout(file.get(), calculateFileSize(file));
+  format_ = layout.format;
+  block_align_ = layout.block_align;
+  data_offset_ = layout.data_offset;
+  data_size_ = layout.data_size;
+  fd_ = file.release();
+  file_path_ = input_file_path;
+}
 
-  // Validate the header
-  uint32_t expected_num_samples = header.data_chunk_size / 2;
-  if (expected_num_samples > getNumSamples()) {
-    throw std::runtime_error("More samples in header than can exist in file.");
-  }
+Reader::~Reader() {
+  FileDescriptor(fd_).close();
 }
 
 uint32_t Reader::getNumSamples() {
-  return calculateNumberOfSamples(wav_file_);
+  return data_size_ / block_align_;
 }
 
 uint32_t Reader::getDuration() {
-  return calculateDuration(wav_file_);
+  return static_cast<uint32_t>(uint64_t{getNumSamples()} * 1000 /
+                               format_.sample_rate);
 }
 
 uint32_t Reader::getFileSize() {
-  return calculateFileSize(wav_file_);
+  const off_t size = ::lseek(fd_, 0, SEEK_END);
+  if (size < 0) {
+    throw std::runtime_error("Failed to get file size.");
+  }
+  return static_cast<uint32_t>(size);
+}
+
+uint32_t Reader::getBitsPerSample() const {
+  return bytesPerSample(format_.sample_format) * 8;
+}
+
+void Reader::requirePcm16Mono() const {
+  if (format_.sample_format != SampleFormat::PCM_16 ||
+      format_.num_channels != 1) {
+    throw std::runtime_error("Not a 16-bit mono file, use read() instead.");
+  }
 }
 
 void Reader::getAllSamples(std::vector<int16_t> &samples) {
+  requirePcm16Mono();
   const uint32_t num_samples = getNumSamples();
-  samples.clear();
-  samples.reserve(num_samples);
+  samples.resize(num_samples);
+
+  // Read in blocks so that a filter can process each block while it is
+  // still in cache.
+  for (uint32_t offset = 0; offset < num_samples;
+       offset += WRITER_BUFFER_SIZE) {
+    const uint32_t count =
+        std::min<uint32_t>(WRITER_BUFFER_SIZE, num_samples - offset);
+    readAt(fd_, samples.data() + offset, count * sizeof(int16_t),
+           data_offset_ + uint64_t{offset} * sizeof(int16_t));
+    if (filter_ != nullptr) {
+      filter_->process(samples.data() + offset, count);
+    }
+  }
+}
+
+BlockRange Reader::blocks(uint32_t block_size) {
+  requirePcm16Mono();
+  if (block_size == 0) {
+    throw std::runtime_error("The block size must be at least 1.");
+  }
+  // Let the kernel read ahead aggressively over the data chunk.
+  ::posix_fadvise(fd_, static_cast<off_t>(data_offset_), data_size_,
+                  POSIX_FADV_SEQUENTIAL);
+  return BlockRange(*this, block_size);
+}
 
-  // Jump to the beginning of the data chunk.
-  wav_file_.seekg(HEADER_SIZE, std::ios::beg);
+void Reader::visitBlocks(
+    const std::function<void(const SampleBlock &)> &visitor,
+    uint32_t block_size) {
+  for (const auto &block : blocks(block_size)) {
+    visitor(block);
+  }
+}
 
-  int16_t sample = 0;
-  for (uint32_t i = 0; i < num_samples; i++) {
-    wav_file_.read(reinterpret_cast<char *>(&sample), 2);
-    samples.push_back(sample);
+const Overview &Reader::getOverview(uint32_t num_threads) {
+  if (overview_ != nullptr) {
+    return *overview_;
   }
+  requirePcm16Mono();
+
+  const std::string sidecar = Overview::sidecarPath(file_path_);
+  if (::access(sidecar.c_str(), R_OK) == 0) {
+    try {
+      Overview overview = Overview::loadSidecar(file_path_);
+      if (overview.getNumSamples() == getNumSamples()) {
+        overview_ = std::make_unique<Overview>(std::move(overview));
+        return *overview_;
+      }
+    } catch (const std::runtime_error &) {
+      // A stale or damaged sidecar, build a new overview instead.
+    }
+  }
+  overview_ =
+      std::make_unique<Overview>(Overview::build(file_path_, num_threads));
+  return *overview_;
+}
+
+uint32_t Reader::readBlock(int16_t *buffer, uint32_t first_sample,
+                           uint32_t num_samples) {
+  const uint32_t total = getNumSamples();
+  if (first_sample >= total) {
+    return 0;
+  }
+  num_samples = std::min(num_samples, total - first_sample);
+  const uint64_t position =
+      data_offset_ + uint64_t{first_sample} * sizeof(int16_t);
+  const size_t num_bytes = size_t{num_samples} * sizeof(int16_t);
+  readAt(fd_, buffer, num_bytes, position);
+
+  // Start reading the next block while the caller processes this one.
+  ::posix_fadvise(fd_, static_cast<off_t>(position + num_bytes),
+                  static_cast<off_t>(num_bytes), POSIX_FADV_WILLNEED);
+
+  if (filter_ != nullptr) {
+    filter_->process(buffer, num_samples);
+  }
+  return num_samples;
+}
+
+uint32_t Reader::read(float *output, uint32_t first_sample,
+                      uint32_t num_samples, ChannelMode mode) {
+  return readDecoded(output, first_sample, num_samples, mode);
+}
+
+uint32_t Reader::read(double *output, uint32_t first_sample,
+                      uint32_t num_samples, ChannelMode mode) {
+  return readDecoded(output, first_sample, num_samples, mode);
+}
+
+uint32_t Reader::readPlanar(int16_t *const *channels, uint32_t first_sample,
+                            uint32_t num_samples) {
+  if (format_.sample_format != SampleFormat::PCM_16) {
+    throw std::runtime_error("Not a 16-bit file, use read() instead.");
+  }
+  const uint32_t total = getNumSamples();
+  if (first_sample >= total) {
+    return 0;
+  }
+  num_samples = std::min(num_samples, total - first_sample);
+
+  const uint16_t num_channels = format_.num_channels;
+  frame_buffer_.resize(size_t{WRITER_BUFFER_SIZE} * num_channels);
+  for (uint32_t offset = 0; offset < num_samples;
+       offset += WRITER_BUFFER_SIZE) {
+    const uint32_t count =
+        std::min<uint32_t>(WRITER_BUFFER_SIZE, num_samples - offset);
+    readAt(fd_, frame_buffer_.data(), size_t{count} * block_align_,
+           data_offset_ + uint64_t{first_sample + offset} * block_align_);
+    deinterleave(frame_buffer_.data(), num_channels, count, channels, offset);
+  }
+  return num_samples;
+}
+
+template <typename T>
+uint32_t Reader::readDecoded(T *output, uint32_t first_sample,
+                             uint32_t num_samples, ChannelMode mode) {
+  const uint32_t total = getNumSamples();
+  if (first_sample >= total) {
+    return 0;
+  }
+  num_samples = std::min(num_samples, total - first_sample);
+
+  const bool downmix = mode == ChannelMode::DOWNMIX;
+  const uint32_t values_per_sample = downmix ? 1 : format_.num_channels;
+  read_buffer_.resize(size_t{WRITER_BUFFER_SIZE} * block_align_);
+
+  for (uint32_t offset = 0; offset < num_samples;
+       offset += WRITER_BUFFER_SIZE) {
+    const uint32_t count =
+        std::min<uint32_t>(WRITER_BUFFER_SIZE, num_samples - offset);
+    readAt(fd_, read_buffer_.data(), size_t{count} * block_align_,
+           data_offset_ + uint64_t{first_sample + offset} * block_align_);
+
+    T *block = output + size_t{offset} * values_per_sample;
+    decodeFrames(format_.sample_format, read_buffer_.data(), block, count,
+                 format_.num_channels, downmix);
+    if constexpr (std::is_same_v<T, float>) {
+      if (filter_ != nullptr && values_per_sample == 1) {
+        filter_->process(block, count);
+      }
+    }
+  }
+  return num_samples;
+}
+
+void Reader::setFilter(Filter *filter) {
+  filter_ = filter;
+}
+
+BlockRange::BlockRange(Reader &reader, uint32_t block_size)
+    : reader_(reader), block_size_(block_size) {
+}
+
+BlockRange::Iterator BlockRange::begin() {
+  if (started_) {
+    throw std::runtime_error("Blocks can only be iterated once.");
+  }
+  started_ = true;
+  buffer_.resize(block_size_);
+  block_.samples = buffer_.data();
+  block_.num_samples = reader_.readBlock(buffer_.data(), 0, block_size_);
+  return Iterator(block_.num_samples > 0 ? this : nullptr);
+}
+
+bool BlockRange::next() {
+  block_.first_sample += block_.num_samples;
+  block_.num_samples =
+      reader_.readBlock(buffer_.data(), block_.first_sample, block_size_);
+  return block_.num_samples > 0;
 }
 
-} // namespace wavgen
\ No newline at end of file
+} // namespace wavgen
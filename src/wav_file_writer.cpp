@@ -7,56 +7,383 @@
  */
 
 #include "file.hpp"
+#include "interleave.hpp"
+#include "wav_filter.hpp"
 #include "wav_gen.hpp"
+#include "wav_overview.hpp"
 
 #include <algorithm>
+#include <cstring>
 
 namespace wavgen {
 
-Writer::Writer(std::string output_filename) {
-  wav_file_.open(output_filename, std::ios::binary);
-  validateFileOpen(wav_file_);
+Writer::Writer() : owned_buffer_(WRITER_BUFFER_SIZE) {
+  buffer_ = owned_buffer_.data();
+  buffer_size_ = WRITER_BUFFER_SIZE;
+}
+
+Writer::Writer(std::string output_filename) : Writer() {
+  open(output_filename);
+}
+
+Writer::Writer(int16_t *buffer, uint32_t buffer_size)
+    : buffer_(buffer), buffer_size_(buffer_size) {
+  if (buffer == nullptr || buffer_size == 0) {
+    buffer_size_ = 0;
+    fail(Status::INVALID_ARGUMENT, "The sample buffer is empty.");
+  }
+}
 
-  WavHeader header;
-  wav_file_ << header; // Write the header to the file to reserve space
-  wav_file_.seekp(0, std::ios::end); // Jump to the end of the file
+Writer::Writer(Writer &&other)
+    : WavFile(), fd_(other.fd_), owns_fd_(other.owns_fd_),
+      buffer_(other.buffer_), buffer_size_(other.buffer_size_),
+      buffered_samples_(other.buffered_samples_),
+      owned_buffer_(std::move(other.owned_buffer_)),
+      num_channels_(other.num_channels_), num_samples_(other.num_samples_),
+      samples_written_(other.samples_written_), filter_(other.filter_),
+      checkpoint_policy_(other.checkpoint_policy_),
+      checkpoint_samples_(other.checkpoint_samples_),
+      checkpoint_time_(other.checkpoint_time_),
+      file_path_(std::move(other.file_path_)),
+      overview_(std::move(other.overview_)), status_(other.status_) {
+  if (!owned_buffer_.empty()) {
+    buffer_ = owned_buffer_.data();
+  }
+  other.fd_ = -1;
+  other.buffer_ = nullptr;
+  other.buffer_size_ = 0;
+  other.buffered_samples_ = 0;
+  other.num_samples_ = 0;
+  other.samples_written_ = 0;
+  other.filter_ = nullptr;
+}
+
+Writer &Writer::operator=(Writer &&other) {
+  if (this != &other) {
+    if (isOpen()) {
+      done();
+    }
+    fd_ = other.fd_;
+    owns_fd_ = other.owns_fd_;
+    buffer_ = other.buffer_;
+    buffer_size_ = other.buffer_size_;
+    buffered_samples_ = other.buffered_samples_;
+    owned_buffer_ = std::move(other.owned_buffer_);
+    if (!owned_buffer_.empty()) {
+      buffer_ = owned_buffer_.data();
+    }
+    num_channels_ = other.num_channels_;
+    num_samples_ = other.num_samples_;
+    samples_written_ = other.samples_written_;
+    filter_ = other.filter_;
+    checkpoint_policy_ = other.checkpoint_policy_;
+    checkpoint_samples_ = other.checkpoint_samples_;
+    checkpoint_time_ = other.checkpoint_time_;
+    file_path_ = std::move(other.file_path_);
+    overview_ = std::move(other.overview_);
+    status_ = other.status_;
+    other.fd_ = -1;
+    other.buffer_ = nullptr;
+    other.buffer_size_ = 0;
+    other.buffered_samples_ = 0;
+    other.num_samples_ = 0;
+    other.samples_written_ = 0;
+    other.filter_ = nullptr;
+  }
+  return *this;
 }
 
 Writer::~Writer() {
-  if (wav_file_.is_open()) {
+#ifndef WAVGEN_NO_EXCEPTIONS
+  try {
+#endif
+    if (isOpen()) {
+      done();
+    }
+#ifndef WAVGEN_NO_EXCEPTIONS
+  } catch (const std::runtime_error &) {
+    // Destructors must not throw, the error is lost.
+  }
+#endif
+}
+
+void Writer::open(std::string output_filename) {
+  if (isOpen()) {
+    done();
+  }
+
+  const int fd = ::open(output_filename.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+#ifndef WAVGEN_NO_EXCEPTIONS
+    status_ = status_ == Status::OK ? Status::OPEN_FAILED : status_;
+    throw std::runtime_error("Failed to open " + output_filename + ": " +
+                             std::strerror(errno));
+#else
+    fail(Status::OPEN_FAILED, "Failed to open file.");
+    return;
+#endif
+  }
+
+  // Closes the file if open(fd) fails, whether it throws or not.
+  FileDescriptor file(fd);
+  open(file.get());
+  if (isOpen()) {
+    file.release();
+    owns_fd_ = true;
+    file_path_ = output_filename;
+  }
+}
+
+void Writer::open(int fd) {
+  if (isOpen()) {
     done();
   }
+
+  // Write a valid header for an empty file to reserve space, a file that is
+  // never finished is still readable.
+  const auto empty_header = packHeader(makeHeader(0, num_channels_));
+  if (!tryWriteAt(fd, empty_header.data(), empty_header.size(), 0)) {
+    fail(Status::WRITE_FAILED, "Failed to write file.");
+    return;
+  }
+
+  fd_ = fd;
+  owns_fd_ = false;
+  file_path_.clear();
+  buffered_samples_ = 0;
+  num_samples_ = 0;
+  samples_written_ = 0;
+  checkpoint_samples_ = 0;
+  checkpoint_time_ = std::chrono::steady_clock::now();
+  if (overview_ != nullptr) {
+    *overview_ = Overview();
+  }
+}
+
+bool Writer::isOpen() const {
+  return fd_ >= 0;
 }
 
+// Samples may still be in the buffer, so these are based on the number of
+// samples added rather than the size of the file.
 uint32_t Writer::getNumSamples() {
-  return calculateNumberOfSamples(wav_file_);
+  return num_samples_ / num_channels_;
 }
 
 uint32_t Writer::getDuration() {
-  return calculateDuration(wav_file_);
+  return getNumSamples() / SAMPLE_RATE_MS;
 }
 
 uint32_t Writer::getFileSize() {
-  return calculateFileSize(wav_file_);
+  return HEADER_SIZE + num_samples_ * 2;
 }
 
 void Writer::addSample(double sample) {
   std::clamp(sample, -1.0, 1.0);
   int16_t sample_int = static_cast<int16_t>(sample * MAX_SAMPLE_AMPLITUDE);
-  writeBytes<2>(wav_file_, sample_int);
+  addSample(sample_int);
 }
 
 void Writer::addSample(int16_t sample) {
-  writeBytes<2>(wav_file_, sample);
+  if (buffer_size_ == 0) {
+    fail(Status::INVALID_ARGUMENT, "The sample buffer is empty.");
+    return;
+  }
+  buffer_[buffered_samples_++] = sample;
+  num_samples_++;
+  if (buffered_samples_ == buffer_size_) {
+    flush();
+  }
+}
+
+void Writer::addSamples(const int16_t *samples, uint32_t num_samples) {
+  if (buffer_size_ == 0 && num_samples > 0) {
+    fail(Status::INVALID_ARGUMENT, "The sample buffer is empty.");
+    return;
+  }
+  while (num_samples > 0) {
+    const uint32_t count =
+        std::min(num_samples, buffer_size_ - buffered_samples_);
+    std::copy_n(samples, count, buffer_ + buffered_samples_);
+    buffered_samples_ += count;
+    num_samples_ += count;
+    if (buffered_samples_ == buffer_size_) {
+      flush();
+    }
+    samples += count;
+    num_samples -= count;
+  }
+}
+
+void Writer::setNumChannels(uint16_t num_channels) {
+  if (num_channels == 0 || num_channels > buffer_size_) {
+    fail(Status::INVALID_ARGUMENT, "Invalid number of channels.");
+    return;
+  }
+  if (num_samples_ > 0) {
+    fail(Status::INVALID_ARGUMENT,
+         "The number of channels can not change after adding samples.");
+    return;
+  }
+  if (num_channels > 1 && (filter_ != nullptr || overview_ != nullptr)) {
+    fail(Status::INVALID_ARGUMENT,
+         "Filters and overviews are only supported for mono files.");
+    return;
+  }
+  num_channels_ = num_channels;
+  if (isOpen()) {
+    checkpoint(); // The header written by open() has the old channel count.
+  }
+}
+
+void Writer::addFrames(const int16_t *const *channels, uint32_t num_frames) {
+  uint32_t frame = 0;
+  while (frame < num_frames) {
+    // Only whole frames are interleaved into the buffer. If there is less
+    // than a frame of space left, write out what is there.
+    uint32_t space = (buffer_size_ - buffered_samples_) / num_channels_;
+    if (space == 0) {
+      flush();
+      space = buffer_size_ / num_channels_;
+      if (space == 0) {
+        fail(Status::INVALID_ARGUMENT, "The sample buffer is empty.");
+        return;
+      }
+    }
+    const uint32_t count = std::min(num_frames - frame, space);
+    interleave(channels, num_channels_, frame, count,
+               buffer_ + buffered_samples_);
+    buffered_samples_ += count * num_channels_;
+    num_samples_ += count * num_channels_;
+    if (buffered_samples_ == buffer_size_) {
+      flush();
+    }
+    frame += count;
+  }
+}
+
+void Writer::setFilter(Filter *filter) {
+  if (filter != nullptr && num_channels_ > 1) {
+    fail(Status::INVALID_ARGUMENT,
+         "Filters are only supported for mono files.");
+    return;
+  }
+  filter_ = filter;
+}
+
+void Writer::setCheckpointPolicy(const CheckpointPolicy &policy) {
+  checkpoint_policy_ = policy;
+}
+
+void Writer::checkpoint() {
+  if (!isOpen()) {
+    fail(Status::NOT_OPEN, "File is not open");
+    return;
+  }
+  const auto header = packHeader(
+      makeHeader(samples_written_ * sizeof(int16_t), num_channels_));
+  if (!tryWriteAt(fd_, header.data(), header.size(), 0)) {
+    fail(Status::WRITE_FAILED, "Failed to write file.");
+    return;
+  }
+  checkpoint_samples_ = samples_written_;
+  checkpoint_time_ = std::chrono::steady_clock::now();
+}
+
+void Writer::fail(Status status, const char *message) {
+  if (status_ == Status::OK) {
+    status_ = status;
+  }
+#ifndef WAVGEN_NO_EXCEPTIONS
+  throw std::runtime_error(message);
+#else
+  (void)message;
+#endif
+}
+
+void Writer::enableOverview() {
+  if (num_channels_ > 1) {
+    fail(Status::INVALID_ARGUMENT,
+         "Overviews are only supported for mono files.");
+    return;
+  }
+  if (overview_ == nullptr) {
+    overview_ = std::make_unique<Overview>();
+  }
+}
+
+void Writer::flush() {
+  if (buffered_samples_ == 0) {
+    return;
+  }
+  // The buffer is emptied even if writing fails, so a writer without
+  // exceptions keeps running (and dropping samples) instead of overflowing.
+  const uint32_t count = buffered_samples_;
+  buffered_samples_ = 0;
+  if (!isOpen()) {
+    fail(Status::NOT_OPEN, "File is not open");
+    return;
+  }
+
+  // Filter the block while it is still in cache, right before writing it.
+  if (filter_ != nullptr) {
+    filter_->process(buffer_, count);
+  }
+  if (overview_ != nullptr) {
+    overview_->addSamples(buffer_, count);
+  }
+  if (!tryWriteAt(fd_, buffer_, count * sizeof(int16_t),
+                  HEADER_SIZE + uint64_t{samples_written_} *
+                                    sizeof(int16_t))) {
+    fail(Status::WRITE_FAILED, "Failed to write file.");
+    return;
+  }
+  samples_written_ += count;
+
+  const auto &policy = checkpoint_policy_;
+  bool due = policy.every_samples > 0 &&
+             samples_written_ - checkpoint_samples_ >= policy.every_samples;
+  if (!due && policy.every_ms > 0) {
+    due = std::chrono::steady_clock::now() - checkpoint_time_ >=
+          std::chrono::milliseconds(policy.every_ms);
+  }
+  if (due) {
+    checkpoint();
+  }
 }
 
 void Writer::done() {
-  validateFileOpen(wav_file_);
-  WavHeader header;
-  header.data_chunk_size = calculateDataChunkSize(wav_file_);
-  header.file_size = calculateHeaderFileSize(wav_file_);
-  wav_file_ << header;
-  wav_file_.close();
+  if (!isOpen()) {
+    fail(Status::NOT_OPEN, "File is not open");
+    return;
+  }
+
+  // Close the file even if a write fails.
+  struct Closer {
+    int &fd;
+    bool owns_fd;
+    ~Closer() {
+      if (owns_fd) {
+        ::close(fd);
+      }
+      fd = -1;
+    }
+  } closer{fd_, owns_fd_};
+
+  flush();
+  const auto header = packHeader(
+      makeHeader(samples_written_ * sizeof(int16_t), num_channels_));
+  if (!tryWriteAt(fd_, header.data(), header.size(), 0)) {
+    fail(Status::WRITE_FAILED, "Failed to write file.");
+    return;
+  }
+
+  if (overview_ != nullptr && !file_path_.empty() &&
+      !overview_->trySaveSidecar(file_path_)) {
+    fail(Status::WRITE_FAILED, "Failed to write overview.");
+    return;
+  }
 }
 
-} // namespace wavgen
\ No newline at end of file
+} // namespace wavgen
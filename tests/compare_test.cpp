@@ -0,0 +1,163 @@
+#include <cmath>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_gen.hpp"
+#include "wav_tools.hpp"
+
+const std::vector<std::string> kTestFiles = {"reference.wav", "test.wav"};
+
+class CompareTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    TearDown();
+  }
+
+  void TearDown() override {
+    for (const auto &file : kTestFiles) {
+      if (std::filesystem::exists(file)) {
+        std::filesystem::remove(file);
+      }
+    }
+  }
+
+  static std::vector<int16_t> sine(uint32_t num_samples) {
+    std::vector<int16_t> samples(num_samples);
+    for (uint32_t i = 0; i < num_samples; i++) {
+      samples[i] = static_cast<int16_t>(10000 * std::sin(i * 0.01));
+    }
+    return samples;
+  }
+
+  static void write(const std::string &path,
+                    const std::vector<int16_t> &samples) {
+    wavgen::Writer writer(path);
+    writer.addSamples(samples.data(), samples.size());
+  }
+};
+
+TEST_F(CompareTest, IdenticalFilesMatch) {
+  const auto samples = sine(10000);
+  write(kTestFiles[0], samples);
+  write(kTestFiles[1], samples);
+
+  const auto result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1]);
+  EXPECT_TRUE(result.matches());
+  EXPECT_TRUE(result.formats_match);
+  EXPECT_EQ(result.reference_samples, 10000);
+  EXPECT_EQ(result.num_mismatches, 0);
+  EXPECT_EQ(result.first_mismatch, -1);
+  EXPECT_EQ(result.max_difference, 0);
+  EXPECT_TRUE(std::isinf(result.snr_db));
+}
+
+TEST_F(CompareTest, FindsMismatchesAboveTheTolerance) {
+  const auto reference = sine(10000);
+  auto test = reference;
+  test[5000] += 1;
+  test[7000] -= 3;
+  test[9999] += 5;
+  write(kTestFiles[0], reference);
+  write(kTestFiles[1], test);
+
+  auto result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1]);
+  EXPECT_FALSE(result.matches());
+  EXPECT_EQ(result.num_mismatches, 3);
+  EXPECT_EQ(result.first_mismatch, 5000);
+  EXPECT_EQ(result.max_difference, 5);
+
+  double signal = 0.0;
+  for (int16_t sample : reference) {
+    signal += static_cast<double>(sample) * sample;
+  }
+  EXPECT_NEAR(result.snr_db, 10.0 * std::log10(signal / (1 + 9 + 25)), 1e-9);
+
+  result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1], {3, 0});
+  EXPECT_EQ(result.num_mismatches, 1);
+  EXPECT_EQ(result.first_mismatch, 9999);
+  EXPECT_EQ(result.max_difference, 5);
+
+  result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1], {5, 0});
+  EXPECT_TRUE(result.matches());
+}
+
+TEST_F(CompareTest, ComparesInParallelChunks) {
+  // Large enough to be split between threads, with mismatches in several
+  // chunks.
+  const auto reference = sine(3'000'001);
+  auto test = reference;
+  for (uint32_t i = 123'457; i < test.size(); i += 500'000) {
+    test[i] += 2;
+  }
+  write(kTestFiles[0], reference);
+  write(kTestFiles[1], test);
+
+  for (uint32_t num_threads : {1, 3, 8}) {
+    const auto result =
+        wavgen::compareFiles(kTestFiles[0], kTestFiles[1], {0, num_threads});
+    EXPECT_EQ(result.num_mismatches, 6) << num_threads;
+    EXPECT_EQ(result.first_mismatch, 123'457) << num_threads;
+    EXPECT_EQ(result.max_difference, 2) << num_threads;
+  }
+}
+
+TEST_F(CompareTest, HandlesFullScaleDifferences) {
+  // Differences up to 65535 and squares up to 2^32, not a multiple of the
+  // vector width.
+  std::vector<int16_t> reference(10003);
+  std::vector<int16_t> test(reference.size());
+  double signal = 0.0;
+  double noise = 0.0;
+  for (size_t i = 0; i < reference.size(); i++) {
+    reference[i] = i % 3 == 0 ? INT16_MIN : static_cast<int16_t>(i * 37);
+    test[i] = i % 2 == 0 ? INT16_MAX : reference[i];
+    const double difference = static_cast<double>(reference[i]) - test[i];
+    signal += static_cast<double>(reference[i]) * reference[i];
+    noise += difference * difference;
+  }
+  write(kTestFiles[0], reference);
+  write(kTestFiles[1], test);
+
+  auto result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1]);
+  EXPECT_EQ(result.num_mismatches, 5002);
+  EXPECT_EQ(result.first_mismatch, 0);
+  EXPECT_EQ(result.max_difference, 65535);
+  EXPECT_NEAR(result.snr_db, 10.0 * std::log10(signal / noise), 1e-9);
+
+  result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1], {65534, 0});
+  EXPECT_EQ(result.num_mismatches, 1668); // Every 6th sample.
+  EXPECT_EQ(result.first_mismatch, 0);
+  result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1], {65535, 0});
+  EXPECT_EQ(result.num_mismatches, 0);
+  EXPECT_EQ(result.first_mismatch, -1);
+}
+
+TEST_F(CompareTest, ReportsDifferentLengthsAndFormats) {
+  const auto samples = sine(1000);
+  write(kTestFiles[0], samples);
+  write(kTestFiles[1], std::vector<int16_t>(samples.begin(),
+                                            samples.begin() + 600));
+
+  auto result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1]);
+  EXPECT_FALSE(result.matches());
+  EXPECT_EQ(result.num_mismatches, 0);
+  EXPECT_EQ(result.first_mismatch, 600);
+  EXPECT_EQ(result.test_samples, 600);
+
+  {
+    wavgen::Writer writer(kTestFiles[1]);
+    writer.setNumChannels(2);
+    writer.addSamples(samples.data(), samples.size());
+  }
+  result = wavgen::compareFiles(kTestFiles[0], kTestFiles[1]);
+  EXPECT_FALSE(result.formats_match);
+  EXPECT_FALSE(result.matches());
+  EXPECT_EQ(result.num_mismatches, 0);
+}
+
+TEST_F(CompareTest, ThrowsForMissingFiles) {
+  write(kTestFiles[0], sine(10));
+  EXPECT_THROW(wavgen::compareFiles(kTestFiles[0], "missing.wav"),
+               std::runtime_error);
+}
@@ -0,0 +1,116 @@
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_gen.hpp"
+#include "wav_overview.hpp"
+#include "wav_tools.hpp"
+
+const std::vector<std::string> kTestFiles = {"first.wav", "second.wav",
+                                             "joined.wav"};
+
+class EditTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    TearDown();
+  }
+
+  void TearDown() override {
+    for (const auto &file : kTestFiles) {
+      if (std::filesystem::exists(file)) {
+        std::filesystem::remove(file);
+      }
+    }
+  }
+
+  static std::vector<int16_t> ramp(int16_t first, uint32_t num_samples) {
+    std::vector<int16_t> samples(num_samples);
+    for (uint32_t i = 0; i < num_samples; i++) {
+      samples[i] = static_cast<int16_t>(first + i);
+    }
+    return samples;
+  }
+
+  static void write(const std::string &path,
+                    const std::vector<int16_t> &samples) {
+    wavgen::Writer writer(path);
+    writer.addSamples(samples.data(), samples.size());
+  }
+
+  static std::vector<int16_t> read(const std::string &path) {
+    std::vector<int16_t> samples;
+    wavgen::Reader reader(path);
+    reader.getAllSamples(samples);
+    return samples;
+  }
+};
+
+TEST_F(EditTest, ConcatenatesFiles) {
+  const auto first = ramp(0, 5000);
+  const auto second = ramp(-100, 123);
+  write(kTestFiles[0], first);
+  write(kTestFiles[1], second);
+
+  EXPECT_EQ(wavgen::concatFiles({kTestFiles[0], kTestFiles[1], kTestFiles[0]},
+                                kTestFiles[2]),
+            5000 + 123 + 5000);
+
+  auto expected = first;
+  expected.insert(expected.end(), second.begin(), second.end());
+  expected.insert(expected.end(), first.begin(), first.end());
+  EXPECT_EQ(read(kTestFiles[2]), expected);
+}
+
+TEST_F(EditTest, RejectsAnOutputThatIsAnInput) {
+  const auto first = ramp(0, 5000);
+  write(kTestFiles[0], first);
+  write(kTestFiles[1], ramp(-100, 123));
+
+  EXPECT_THROW(wavgen::concatFiles({kTestFiles[0], kTestFiles[1]},
+                                   kTestFiles[0]),
+               std::runtime_error);
+  EXPECT_THROW(wavgen::concatFiles({kTestFiles[1], kTestFiles[0]},
+                                   "./" + kTestFiles[0]),
+               std::runtime_error);
+  EXPECT_THROW(wavgen::extractSamples(kTestFiles[0], kTestFiles[0], 10, 100),
+               std::runtime_error);
+  EXPECT_THROW(wavgen::splitFile(kTestFiles[0], {300},
+                                 {kTestFiles[1], kTestFiles[0]}),
+               std::runtime_error);
+  EXPECT_EQ(read(kTestFiles[0]), first);
+}
+
+TEST_F(EditTest, SplitsAndExtracts) {
+  const auto samples = ramp(0, 1000);
+  write(kTestFiles[2], samples);
+
+  wavgen::splitFile(kTestFiles[2], {300}, {kTestFiles[0], kTestFiles[1]});
+  EXPECT_EQ(read(kTestFiles[0]),
+            std::vector<int16_t>(samples.begin(), samples.begin() + 300));
+  EXPECT_EQ(read(kTestFiles[1]),
+            std::vector<int16_t>(samples.begin() + 300, samples.end()));
+
+  wavgen::extractSamples(kTestFiles[2], kTestFiles[0], 990, 100);
+  EXPECT_EQ(read(kTestFiles[0]),
+            std::vector<int16_t>(samples.begin() + 990, samples.end()));
+
+  EXPECT_THROW(wavgen::splitFile(kTestFiles[2], {300}, {kTestFiles[0]}),
+               std::runtime_error);
+}
+
+TEST_F(EditTest, TrimsInPlace) {
+  const auto samples = ramp(0, 1000);
+  {
+    wavgen::Writer writer(kTestFiles[0]);
+    writer.enableOverview();
+    writer.addSamples(samples.data(), samples.size());
+  }
+  const std::string sidecar = wavgen::Overview::sidecarPath(kTestFiles[0]);
+  ASSERT_TRUE(std::filesystem::exists(sidecar));
+
+  EXPECT_EQ(wavgen::trimFile(kTestFiles[0], 400), 400);
+  EXPECT_FALSE(std::filesystem::exists(sidecar));
+  EXPECT_EQ(std::filesystem::file_size(kTestFiles[0]), 44 + 400 * 2);
+  EXPECT_EQ(read(kTestFiles[0]),
+            std::vector<int16_t>(samples.begin(), samples.begin() + 400));
+}
@@ -0,0 +1,129 @@
+#include <cmath>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_filter.hpp"
+#include "wav_gen.hpp"
+
+const std::string kTestFileName = "test.wav";
+
+class FilterTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    // Delete the file if it exists.
+    if (std::filesystem::exists(kTestFileName)) {
+      std::filesystem::remove(kTestFileName);
+    }
+    // Assert that the file does not exist.
+    ASSERT_FALSE(std::filesystem::exists(kTestFileName));
+  }
+
+  void TearDown() override {
+    // Delete the file if it exists.
+    if (std::filesystem::exists(kTestFileName)) {
+      std::filesystem::remove(kTestFileName);
+    }
+  }
+};
+
+namespace {
+std::vector<float> sineWave(double frequency, size_t num_samples) {
+  const double d_angle = 2.0 * M_PI * frequency / wavgen::SAMPLE_RATE;
+  std::vector<float> samples(num_samples);
+  for (size_t i = 0; i < num_samples; i++) {
+    samples[i] = static_cast<float>(0.5 * std::sin(d_angle * i));
+  }
+  return samples;
+}
+
+float peak(const std::vector<float> &samples, size_t start) {
+  float max = 0.0f;
+  for (size_t i = start; i < samples.size(); i++) {
+    max = std::max(max, std::fabs(samples[i]));
+  }
+  return max;
+}
+} // namespace
+
+TEST_F(FilterTest, BiquadLowPassAttenuatesHighFrequencies) {
+  wavgen::BiquadFilter filter;
+  filter.addSection(wavgen::BiquadFilter::lowPass(500));
+  filter.addSection(wavgen::BiquadFilter::lowPass(500));
+
+  auto low = sineWave(100, 4800);
+  auto high = sineWave(8000, 4800);
+  filter.process(low.data(), low.size());
+  filter.reset();
+  filter.process(high.data(), high.size());
+
+  EXPECT_NEAR(peak(low, 2400), 0.5f, 0.02f);
+  EXPECT_LT(peak(high, 2400), 0.01f);
+}
+
+TEST_F(FilterTest, FirBlockSizeDoesNotChangeOutput) {
+  const auto taps = wavgen::FirFilter::designLowPass(1000, 63);
+  wavgen::FirFilter whole(taps);
+  wavgen::FirFilter pieces(taps);
+
+  auto expected = sineWave(3000, 2000);
+  auto actual = expected;
+  whole.process(expected.data(), expected.size());
+
+  // Process the same signal in odd sized blocks.
+  size_t offset = 0;
+  size_t block = 1;
+  while (offset < actual.size()) {
+    const size_t count = std::min(block, actual.size() - offset);
+    pieces.process(actual.data() + offset, count);
+    offset += count;
+    block = block * 3 + 1;
+  }
+
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_FLOAT_EQ(expected[i], actual[i]) << "Sample " << i;
+  }
+}
+
+TEST_F(FilterTest, PartitionedFirMatchesDirectConvolution) {
+  constexpr size_t kNumTaps = 1001;
+  const auto taps = wavgen::FirFilter::designBandPass(800, 1600, kNumTaps);
+  wavgen::FirFilter filter(taps);
+  ASSERT_TRUE(filter.isPartitioned());
+
+  auto input = sineWave(1200, 3000);
+  for (size_t i = 0; i < input.size(); i += 7) {
+    input[i] += 0.25f; // Add some broadband content.
+  }
+  auto output = input;
+  filter.process(output.data(), output.size());
+
+  for (size_t n = 0; n < input.size(); n += 37) {
+    double expected = 0.0;
+    for (size_t k = 0; k < kNumTaps && k <= n; k++) {
+      expected += static_cast<double>(taps[k]) * input[n - k];
+    }
+    ASSERT_NEAR(output[n], expected, 1e-4) << "Sample " << n;
+  }
+}
+
+TEST_F(FilterTest, WriterAppliesFilterBeforeWriting) {
+  wavgen::BiquadFilter filter;
+  filter.addSection(wavgen::BiquadFilter::lowPass(200));
+
+  wavgen::Generator generator(kTestFileName);
+  generator.setFilter(&filter);
+  generator.addSineWaveSamples(10000, 1.0, wavgen::SAMPLE_RATE / 10);
+  generator.done();
+
+  std::vector<int16_t> samples;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(samples);
+  ASSERT_EQ(samples.size(), wavgen::SAMPLE_RATE / 10);
+
+  int16_t max = 0;
+  for (size_t i = samples.size() / 2; i < samples.size(); i++) {
+    max = std::max<int16_t>(max, std::abs(samples[i]));
+  }
+  EXPECT_LT(max, wavgen::MAX_SAMPLE_AMPLITUDE / 100);
+}
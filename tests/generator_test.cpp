@@ -1,3 +1,4 @@
+#include <cmath>
 #include <filesystem>
 
 #include "gtest/gtest.h"
@@ -70,4 +71,233 @@ TEST_F(WavGeneratorTest, AddSineWaveSamples) {
   ASSERT_TRUE(std::filesystem::exists(kTestFileName));
   ASSERT_EQ(std::filesystem::file_size(kTestFileName), kExpectedFileSize);
   ASSERT_EQ(writer_num_samples, kNumSamples);
-}
\ No newline at end of file
+}
+
+namespace {
+/**
+ * @brief The magnitude of a single frequency component (Goertzel).
+ */
+double toneMagnitude(const std::vector<int16_t> &samples, size_t start,
+                     size_t length, double frequency) {
+  const double coefficient =
+      2.0 * std::cos(2.0 * M_PI * frequency / wavgen::SAMPLE_RATE);
+  double s1 = 0.0;
+  double s2 = 0.0;
+  for (size_t i = start; i < start + length; i++) {
+    const double s0 = samples[i] + coefficient * s1 - s2;
+    s2 = s1;
+    s1 = s0;
+  }
+  const double power = s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+  return std::sqrt(std::max(power, 0.0)) / length;
+}
+} // namespace
+
+TEST_F(WavGeneratorTest, AddMultiToneSumsTones) {
+  constexpr uint32_t kNumSamples = 2000;
+  const std::vector<wavgen::Tone> kTones = {
+      {440.0, 0.25}, {1000.5, 0.25}, {2500.0, 0.2}, {3333.3, 0.1}};
+
+  wavgen::Generator wav_file(kTestFileName);
+  // Two calls, the phases must continue across them.
+  wav_file.addMultiTone(kTones, kNumSamples / 2);
+  wav_file.addMultiTone(kTones, kNumSamples / 2);
+  wav_file.done();
+
+  std::vector<int16_t> samples;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(samples);
+  ASSERT_EQ(samples.size(), kNumSamples);
+
+  for (uint32_t i = 0; i < kNumSamples; i++) {
+    double expected = 0.0;
+    for (const auto &tone : kTones) {
+      expected += tone.amplitude *
+                  std::sin(2.0 * M_PI * tone.frequency * (i + 1) /
+                           wavgen::SAMPLE_RATE);
+    }
+    ASSERT_NEAR(samples[i], expected * wavgen::MAX_SAMPLE_AMPLITUDE, 2.0)
+        << "Sample " << i;
+  }
+}
+
+TEST_F(WavGeneratorTest, AddDtmfDigits) {
+  constexpr uint16_t kToneMs = 50;
+  constexpr uint16_t kGapMs = 25;
+  constexpr uint32_t kToneSamples = kToneMs * wavgen::SAMPLE_RATE_MS;
+  constexpr uint32_t kDigitSamples =
+      (kToneMs + kGapMs) * wavgen::SAMPLE_RATE_MS;
+
+  wavgen::Generator wav_file(kTestFileName);
+  wav_file.addDtmf("5#", kToneMs, kGapMs);
+  EXPECT_THROW(wav_file.addDtmf("X", kToneMs, kGapMs), std::runtime_error);
+  EXPECT_THROW(wav_file.addDtmf("12X", kToneMs, kGapMs), std::runtime_error);
+  EXPECT_EQ(wav_file.getNumSamples(), kDigitSamples * 2);
+  wav_file.done();
+
+  std::vector<int16_t> samples;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(samples);
+  ASSERT_EQ(samples.size(), kDigitSamples * 2);
+
+  // 5 is 770 Hz + 1336 Hz, # is 941 Hz + 1477 Hz.
+  EXPECT_GT(toneMagnitude(samples, 0, kToneSamples, 770), 3000);
+  EXPECT_GT(toneMagnitude(samples, 0, kToneSamples, 1336), 3000);
+  EXPECT_LT(toneMagnitude(samples, 0, kToneSamples, 941), 500);
+  EXPECT_GT(toneMagnitude(samples, kDigitSamples, kToneSamples, 941), 3000);
+  EXPECT_GT(toneMagnitude(samples, kDigitSamples, kToneSamples, 1477), 3000);
+  EXPECT_LT(toneMagnitude(samples, kDigitSamples, kToneSamples, 770), 500);
+
+  // The gaps are silent.
+  for (uint32_t i = kToneSamples; i < kDigitSamples; i++) {
+    ASSERT_EQ(samples[i], 0);
+  }
+}
+
+TEST_F(WavGeneratorTest, ToneCacheReusesRepeatedSegments) {
+  // 1200 Hz and 2400 Hz complete a whole number of cycles in 10 ms, so each
+  // segment starts at the same phase.
+  constexpr int kRepeats = 50;
+  std::vector<int16_t> uncached;
+  {
+    wavgen::Generator wav_file(kTestFileName);
+    for (int i = 0; i < kRepeats; i++) {
+      wav_file.addSineWave(1200, 0.5, 10);
+      wav_file.addSineWaveSamples(2400, 0.5, 480);
+    }
+    wav_file.done();
+    wavgen::Reader reader(kTestFileName);
+    reader.getAllSamples(uncached);
+  }
+
+  wavgen::Generator wav_file(kTestFileName);
+  wav_file.enableToneCache(1 << 20);
+  for (int i = 0; i < kRepeats; i++) {
+    wav_file.addSineWave(1200, 0.5, 10);
+    wav_file.addSineWaveSamples(2400, 0.5, 480);
+  }
+  const auto stats = wav_file.getToneCacheStats();
+  wav_file.done();
+
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.hits, kRepeats * 2 - 2);
+  EXPECT_EQ(stats.entries, 2);
+  EXPECT_EQ(stats.bytes, 480 * 2 * sizeof(int16_t));
+  EXPECT_NEAR(stats.getHitRate(), 0.98, 1e-9);
+
+  std::vector<int16_t> cached;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(cached);
+  ASSERT_EQ(cached.size(), uncached.size());
+  // The uncached phase drifts slightly from the rounded cached phase.
+  for (size_t i = 0; i < cached.size(); i++) {
+    ASSERT_NEAR(cached[i], uncached[i], 40) << "Sample " << i;
+  }
+}
+
+TEST_F(WavGeneratorTest, ToneCacheStaysWithinMemoryLimit) {
+  constexpr size_t kSegmentBytes = 480 * sizeof(int16_t);
+
+  wavgen::Generator wav_file(kTestFileName);
+  wav_file.enableToneCache(kSegmentBytes * 2);
+  wav_file.addSineWave(1200, 0.5, 10);
+  wav_file.addSineWave(2400, 0.5, 10);
+  wav_file.addSineWave(4800, 0.5, 10); // Evicts 1200 Hz
+  wav_file.addSineWave(2400, 0.5, 10); // Hit
+  wav_file.addSineWave(1200, 0.5, 10); // Miss, evicts 4800 Hz
+
+  const auto stats = wav_file.getToneCacheStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 4);
+  EXPECT_EQ(stats.evictions, 2);
+  EXPECT_EQ(stats.entries, 2);
+  EXPECT_LE(stats.bytes, kSegmentBytes * 2);
+
+  wav_file.disableToneCache();
+  EXPECT_EQ(wav_file.getToneCacheStats().entries, 0);
+}
+
+TEST_F(WavGeneratorTest, ToneCacheSkipsSegmentsLargerThanTheLimit) {
+  wavgen::Generator wav_file(kTestFileName);
+  wav_file.enableToneCache(480 * sizeof(int16_t));
+  wav_file.addSineWave(1200, 0.5, 1000);
+  wav_file.addSineWave(1200, 0.5, 10);
+
+  const auto stats = wav_file.getToneCacheStats();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.entries, 1);
+  EXPECT_EQ(stats.bytes, 480 * sizeof(int16_t));
+  EXPECT_EQ(wav_file.getNumSamples(), 48480);
+  wav_file.done();
+}
+
+TEST_F(WavGeneratorTest, AddSweepMatchesExactPhase) {
+  constexpr uint32_t kSamples = 48001; // Not a multiple of the block size.
+  constexpr double kAmplitude = 0.5;
+  const std::vector<std::pair<wavgen::SweepShape, std::pair<double, double>>>
+      kSweeps = {{wavgen::SweepShape::LINEAR, {20.0, 20000.0}},
+                 {wavgen::SweepShape::EXPONENTIAL, {20.0, 20000.0}},
+                 {wavgen::SweepShape::EXPONENTIAL, {1000.5, 1000.5}}};
+
+  for (const auto &[shape, range] : kSweeps) {
+    {
+      wavgen::Generator generator(kTestFileName);
+      generator.addSweep(range.first, range.second, kAmplitude, kSamples,
+                         shape);
+    }
+    std::vector<int16_t> samples;
+    wavgen::Reader reader(kTestFileName);
+    reader.getAllSamples(samples);
+    ASSERT_EQ(samples.size(), kSamples);
+
+    // Sum the exact phase increment of each sample.
+    const double d0 = 2 * M_PI * range.first / wavgen::SAMPLE_RATE;
+    const double d1 = 2 * M_PI * range.second / wavgen::SAMPLE_RATE;
+    double angle = 0.0;
+    int max_error = 0;
+    for (uint32_t n = 0; n < kSamples; n++) {
+      const double t = static_cast<double>(n) / (kSamples - 1);
+      angle += shape == wavgen::SweepShape::LINEAR
+                   ? d0 + (d1 - d0) * t
+                   : d0 * std::pow(d1 / d0, t);
+      const int expected = static_cast<int>(
+          kAmplitude * std::sin(angle) * wavgen::MAX_SAMPLE_AMPLITUDE);
+      max_error = std::max(max_error, std::abs(samples[n] - expected));
+    }
+    EXPECT_LE(max_error, 4);
+  }
+}
+
+TEST_F(WavGeneratorTest, AddSweepContinuesPhase) {
+  // The whole sweep rises by 0.5 Hz per sample, the second half starts one
+  // step after the end of the first, so the halves match the whole sweep.
+  auto render = [&](const std::vector<std::pair<double, double>> &sweeps,
+                    const std::vector<uint32_t> &lengths) {
+    {
+      wavgen::Generator generator(kTestFileName);
+      for (size_t i = 0; i < sweeps.size(); i++) {
+        generator.addSweep(sweeps[i].first, sweeps[i].second, 0.5,
+                           lengths[i]);
+      }
+    }
+    std::vector<int16_t> samples;
+    wavgen::Reader reader(kTestFileName);
+    reader.getAllSamples(samples);
+    return samples;
+  };
+  const auto whole = render({{500.0, 1500.0}}, {2001});
+  const auto halves = render({{500.0, 1000.0}, {1000.5, 1500.0}}, {1001, 1000});
+  ASSERT_EQ(whole.size(), 2001);
+  ASSERT_EQ(halves.size(), whole.size());
+  for (size_t n = 0; n < whole.size(); n++) {
+    ASSERT_NEAR(halves[n], whole[n], 2) << n;
+  }
+}
+
+TEST_F(WavGeneratorTest, AddSweepRejectsZeroExponential) {
+  wavgen::Generator generator(kTestFileName);
+  EXPECT_THROW(generator.addSweep(0.0, 1000.0, 0.5, 100,
+                                  wavgen::SweepShape::EXPONENTIAL),
+               std::runtime_error);
+}
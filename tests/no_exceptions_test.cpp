@@ -0,0 +1,139 @@
+// Built with -fno-exceptions (WAVGEN_NO_EXCEPTIONS), where GTest is not
+// available, so failures are counted by hand. Every error of the writer side
+// has to show up in getStatus() instead of aborting.
+
+#include <cstdio>
+#include <string>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "wav_gen.hpp"
+#include "wav_overview.hpp"
+
+namespace {
+
+const char *const kTestFileName = "no_exceptions_test.wav";
+
+int failures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      std::fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__,   \
+                   #condition);                                                \
+      failures++;                                                              \
+    }                                                                          \
+  } while (false)
+
+int countOpenFiles() {
+  DIR *dir = ::opendir("/proc/self/fd");
+  int count = 0;
+  while (::readdir(dir) != nullptr) {
+    count++;
+  }
+  ::closedir(dir);
+  return count;
+}
+
+void writesValidFiles() {
+  wavgen::Generator generator(kTestFileName);
+  generator.addSineWave(1000, 0.5, 10);
+  generator.done();
+  CHECK(generator.getStatus() == wavgen::Status::OK);
+
+  struct stat info {};
+  CHECK(::stat(kTestFileName, &info) == 0);
+  CHECK(info.st_size == 44 + 480 * 2);
+}
+
+void reportsInvalidArguments() {
+  wavgen::Generator generator(kTestFileName);
+  generator.setNumChannels(0);
+  CHECK(generator.getStatus() == wavgen::Status::INVALID_ARGUMENT);
+  CHECK(generator.getNumChannels() == 1);
+
+  generator.clearStatus();
+  generator.addSweep(0.0, 1000.0, 0.5, 100, wavgen::SweepShape::EXPONENTIAL);
+  CHECK(generator.getStatus() == wavgen::Status::INVALID_ARGUMENT);
+  CHECK(generator.getNumSamples() == 0);
+
+  // The writer is still usable after the error.
+  generator.addSineWave(1000, 0.5, 1);
+  CHECK(generator.getNumSamples() == 48);
+  generator.done();
+
+  wavgen::Writer writer(nullptr, 0);
+  CHECK(writer.getStatus() == wavgen::Status::INVALID_ARGUMENT);
+}
+
+void reportsNotOpen() {
+  wavgen::Writer writer;
+  writer.checkpoint();
+  CHECK(writer.getStatus() == wavgen::Status::NOT_OPEN);
+
+  writer.clearStatus();
+  writer.done();
+  CHECK(writer.getStatus() == wavgen::Status::NOT_OPEN);
+}
+
+void reportsOpenAndWriteFailures() {
+  wavgen::Writer writer;
+  writer.open("missing_directory/test.wav");
+  CHECK(writer.getStatus() == wavgen::Status::OPEN_FAILED);
+  CHECK(!writer.isOpen());
+
+  // A read only descriptor, the header can not be written.
+  const int fd = ::open(kTestFileName, O_RDONLY);
+  CHECK(fd >= 0);
+  writer.clearStatus();
+  writer.open(fd);
+  CHECK(writer.getStatus() == wavgen::Status::WRITE_FAILED);
+  CHECK(!writer.isOpen());
+  ::close(fd);
+
+  // The descriptor opened for a path is closed again.
+  const int num_files = countOpenFiles();
+  writer.clearStatus();
+  writer.open("/dev/full");
+  CHECK(writer.getStatus() == wavgen::Status::WRITE_FAILED);
+  CHECK(!writer.isOpen());
+  CHECK(countOpenFiles() == num_files);
+}
+
+void reportsSidecarFailures() {
+  // A directory in the way of the sidecar, done() still finishes the file.
+  const std::string sidecar = wavgen::Overview::sidecarPath(kTestFileName);
+  CHECK(::mkdir(sidecar.c_str(), 0755) == 0);
+  wavgen::Writer writer(kTestFileName);
+  writer.enableOverview();
+  writer.addSample(int16_t{1000});
+  writer.done();
+  CHECK(writer.getStatus() == wavgen::Status::WRITE_FAILED);
+  CHECK(!writer.isOpen());
+  ::rmdir(sidecar.c_str());
+
+  struct stat info {};
+  CHECK(::stat(kTestFileName, &info) == 0);
+  CHECK(info.st_size == 44 + 2);
+}
+
+} // namespace
+
+int main() {
+  writesValidFiles();
+  reportsInvalidArguments();
+  reportsNotOpen();
+  reportsOpenAndWriteFailures();
+  reportsSidecarFailures();
+  ::unlink(kTestFileName);
+
+  if (failures > 0) {
+    std::fprintf(stderr, "%d checks failed.\n", failures);
+    return 1;
+  }
+  std::printf("All checks passed.\n");
+  return 0;
+}
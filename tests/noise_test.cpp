@@ -0,0 +1,149 @@
+#include <cmath>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_gen.hpp"
+
+const std::string kTestFileName = "test.wav";
+const std::string kSecondTestFileName = "test2.wav";
+
+class NoiseTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    // Delete the files if they exist.
+    for (const auto &file : {kTestFileName, kSecondTestFileName}) {
+      if (std::filesystem::exists(file)) {
+        std::filesystem::remove(file);
+      }
+      ASSERT_FALSE(std::filesystem::exists(file));
+    }
+  }
+
+  void TearDown() override {
+    // Delete the files if they exist.
+    for (const auto &file : {kTestFileName, kSecondTestFileName}) {
+      if (std::filesystem::exists(file)) {
+        std::filesystem::remove(file);
+      }
+    }
+  }
+
+  std::vector<int16_t> readSamples(const std::string &file) {
+    std::vector<int16_t> samples;
+    wavgen::Reader reader(file);
+    reader.getAllSamples(samples);
+    return samples;
+  }
+};
+
+namespace {
+double rms(const std::vector<int16_t> &samples) {
+  double sum = 0.0;
+  for (auto sample : samples) {
+    const double value =
+        sample / static_cast<double>(wavgen::MAX_SAMPLE_AMPLITUDE);
+    sum += value * value;
+  }
+  return std::sqrt(sum / samples.size());
+}
+} // namespace
+
+TEST_F(NoiseTest, SameSeedProducesSameNoise) {
+  for (const auto &file : {kTestFileName, kSecondTestFileName}) {
+    wavgen::Generator generator(file);
+    generator.setNoiseSeed(1234);
+    generator.addWhiteNoise(0.5, 1000);
+    generator.addPinkNoise(0.5, 1000);
+    generator.addGaussianNoise(0.1, 1000);
+    generator.done();
+  }
+  EXPECT_EQ(readSamples(kTestFileName), readSamples(kSecondTestFileName));
+
+  {
+    wavgen::Generator generator(kSecondTestFileName);
+    generator.setNoiseSeed(4321);
+    generator.addWhiteNoise(0.5, 1000);
+    generator.addPinkNoise(0.5, 1000);
+    generator.addGaussianNoise(0.1, 1000);
+    generator.done();
+  }
+  EXPECT_NE(readSamples(kTestFileName), readSamples(kSecondTestFileName));
+}
+
+TEST_F(NoiseTest, SplitRenderMatchesSingleRender) {
+  constexpr uint32_t kNumSamples = 10000;
+  constexpr uint32_t kSplit = 3333;
+
+  {
+    wavgen::Generator generator(kTestFileName);
+    generator.setNoiseSeed(99);
+    generator.addPinkNoise(0.8, kNumSamples);
+    generator.addWhiteNoise(0.8, kNumSamples);
+    generator.done();
+  }
+
+  // Render the same sequence as separate pieces, out of order, as parallel
+  // workers would.
+  std::vector<int16_t> pieces(kNumSamples * 2);
+  const uint32_t starts[] = {kSplit, 0, kNumSamples + kSplit, kNumSamples};
+  for (uint32_t start : starts) {
+    const uint32_t end = start < kNumSamples
+                             ? (start == 0 ? kSplit : kNumSamples)
+                             : (start == kNumSamples ? kNumSamples + kSplit
+                                                     : kNumSamples * 2);
+    {
+      wavgen::Generator generator(kSecondTestFileName);
+      generator.setNoiseSeed(99);
+      generator.setNoisePosition(start);
+      if (start < kNumSamples) {
+        generator.addPinkNoise(0.8, end - start);
+      } else {
+        generator.addWhiteNoise(0.8, end - start);
+      }
+      EXPECT_EQ(generator.getNoisePosition(), end);
+      generator.done();
+    }
+    const auto samples = readSamples(kSecondTestFileName);
+    std::copy(samples.begin(), samples.end(), pieces.begin() + start);
+  }
+
+  EXPECT_EQ(readSamples(kTestFileName), pieces);
+}
+
+TEST_F(NoiseTest, GaussianNoiseHasRequestedRms) {
+  wavgen::Generator generator(kTestFileName);
+  generator.setNoiseSeed(7);
+  generator.addGaussianNoise(0.1, wavgen::SAMPLE_RATE);
+  generator.done();
+
+  EXPECT_NEAR(rms(readSamples(kTestFileName)), 0.1, 0.005);
+}
+
+TEST_F(NoiseTest, BandLimitedNoiseHasRequestedRms) {
+  wavgen::Generator generator(kTestFileName);
+  generator.setNoiseSeed(7);
+  generator.addBandLimitedNoise(1000, 3000, 0.05, wavgen::SAMPLE_RATE);
+  generator.done();
+
+  EXPECT_NEAR(rms(readSamples(kTestFileName)), 0.05, 0.01);
+}
+
+TEST_F(NoiseTest, BandLimitedNoiseRejectsInvalidBands) {
+  wavgen::Generator generator(kTestFileName);
+  EXPECT_THROW(generator.addBandLimitedNoise(4000, 300, 0.1, 100),
+               std::runtime_error);
+  EXPECT_THROW(generator.addBandLimitedNoise(300, 30000, 0.1, 100),
+               std::runtime_error);
+  EXPECT_THROW(generator.addBandLimitedNoise(-1, 3000, 0.1, 100),
+               std::runtime_error);
+  EXPECT_EQ(generator.getStatus(), wavgen::Status::INVALID_ARGUMENT);
+  EXPECT_EQ(generator.getNumSamples(), 0);
+
+  // The whole band is plain white noise.
+  generator.clearStatus();
+  generator.addBandLimitedNoise(0, wavgen::SAMPLE_RATE / 2, 0.1,
+                                wavgen::SAMPLE_RATE);
+  generator.done();
+  EXPECT_NEAR(rms(readSamples(kTestFileName)), 0.1, 0.005);
+}
@@ -0,0 +1,101 @@
+#include <cmath>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_gen.hpp"
+#include "wav_tools.hpp"
+
+const std::string kTestFileName = "test.wav";
+
+class NormalizeTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    // Delete the file if it exists.
+    if (std::filesystem::exists(kTestFileName)) {
+      std::filesystem::remove(kTestFileName);
+    }
+    // Assert that the file does not exist.
+    ASSERT_FALSE(std::filesystem::exists(kTestFileName));
+  }
+
+  void TearDown() override {
+    // Delete the file if it exists.
+    if (std::filesystem::exists(kTestFileName)) {
+      std::filesystem::remove(kTestFileName);
+    }
+  }
+};
+
+TEST_F(NormalizeTest, MeasuresLevels) {
+  wavgen::Writer writer(kTestFileName);
+  const std::vector<int16_t> kSamples = {100, -300, 200, 0};
+  writer.addSamples(kSamples.data(), kSamples.size());
+  writer.done();
+
+  const auto stats = wavgen::measureLevels(kTestFileName);
+  EXPECT_EQ(stats.num_samples, 4);
+  EXPECT_EQ(stats.peak, 300);
+  EXPECT_NEAR(stats.rms, std::sqrt((100.0 * 100 + 300 * 300 + 200 * 200) / 4),
+              1e-9);
+}
+
+TEST_F(NormalizeTest, NormalizesPeakInPlace) {
+  {
+    wavgen::Generator generator(kTestFileName);
+    // More than one streaming block.
+    generator.addSineWaveSamples(1000, 0.25, wavgen::SAMPLE_RATE * 2);
+    generator.done();
+  }
+  const auto file_size = std::filesystem::file_size(kTestFileName);
+
+  const auto result =
+      wavgen::normalize(kTestFileName, wavgen::NormalizeMode::PEAK, 0.9);
+  EXPECT_NEAR(result.gain, 3.6, 0.01);
+
+  const auto after = wavgen::measureLevels(kTestFileName);
+  EXPECT_NEAR(after.peak, 0.9 * wavgen::MAX_SAMPLE_AMPLITUDE, 1.0);
+  EXPECT_EQ(after.num_samples, wavgen::SAMPLE_RATE * 2);
+  EXPECT_EQ(std::filesystem::file_size(kTestFileName), file_size);
+
+  // Still a valid file.
+  wavgen::Reader reader(kTestFileName);
+  EXPECT_EQ(reader.getNumSamples(), wavgen::SAMPLE_RATE * 2);
+}
+
+TEST_F(NormalizeTest, NormalizesRmsWithSaturation) {
+  {
+    wavgen::Writer writer(kTestFileName);
+    for (int i = 0; i < 1000; i++) {
+      writer.addSample(static_cast<int16_t>(i % 2 == 0 ? 1000 : -1000));
+    }
+    writer.addSample(static_cast<int16_t>(20000));
+    writer.done();
+  }
+
+  const auto result =
+      wavgen::normalize(kTestFileName, wavgen::NormalizeMode::RMS, 0.5);
+  EXPECT_NEAR(result.before.rms * result.gain,
+              0.5 * wavgen::MAX_SAMPLE_AMPLITUDE, 1e-6);
+
+  std::vector<int16_t> samples;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(samples);
+  ASSERT_EQ(samples.size(), 1001);
+  EXPECT_NEAR(samples[0], 1000 * result.gain, 1.0);
+  EXPECT_EQ(samples[1000], 32767); // Clipped, not wrapped.
+}
+
+TEST_F(NormalizeTest, SilentFileIsUnchanged) {
+  {
+    wavgen::Writer writer(kTestFileName);
+    for (int i = 0; i < 100; i++) {
+      writer.addSample(static_cast<int16_t>(0));
+    }
+    writer.done();
+  }
+
+  const auto result = wavgen::normalize(kTestFileName);
+  EXPECT_EQ(result.before.peak, 0);
+  EXPECT_DOUBLE_EQ(result.gain, 1.0);
+}
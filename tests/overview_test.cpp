@@ -0,0 +1,149 @@
+#include <cmath>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_gen.hpp"
+#include "wav_overview.hpp"
+#include "wav_tools.hpp"
+
+const std::string kTestFileName = "test.wav";
+
+class OverviewTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    TearDown();
+  }
+
+  void TearDown() override {
+    for (const auto &file :
+         {kTestFileName, wavgen::Overview::sidecarPath(kTestFileName)}) {
+      if (std::filesystem::exists(file)) {
+        std::filesystem::remove(file);
+      }
+    }
+  }
+
+  /**
+   * @brief A triangle wave with a slowly growing amplitude, so every bucket
+   * is different.
+   */
+  static std::vector<int16_t> makeSamples(uint32_t num_samples) {
+    std::vector<int16_t> samples(num_samples);
+    for (uint32_t i = 0; i < num_samples; i++) {
+      const int32_t triangle = static_cast<int32_t>(i % 200) - 100;
+      samples[i] = static_cast<int16_t>(triangle * (1 + i / 20000));
+    }
+    return samples;
+  }
+
+  /**
+   * @brief Summarize samples directly.
+   */
+  static wavgen::OverviewBucket summarize(const std::vector<int16_t> &samples,
+                                          size_t first, size_t last) {
+    wavgen::OverviewBucket bucket{INT16_MAX, INT16_MIN, 0.0f};
+    double sum = 0.0;
+    for (size_t i = first; i < last; i++) {
+      bucket.min = std::min(bucket.min, samples[i]);
+      bucket.max = std::max(bucket.max, samples[i]);
+      sum += static_cast<double>(samples[i]) * samples[i];
+    }
+    bucket.rms = static_cast<float>(std::sqrt(sum / (last - first)));
+    return bucket;
+  }
+};
+
+TEST_F(OverviewTest, QueryMatchesSamples) {
+  // Not a multiple of any bucket size.
+  const auto samples = makeSamples(65536 * 3 + 1000);
+  wavgen::Overview overview;
+  overview.addSamples(samples.data(), 1234);
+  overview.addSamples(samples.data() + 1234, samples.size() - 1234);
+  EXPECT_EQ(overview.getNumSamples(), samples.size());
+
+  // One pixel per level 1 bucket, aligned, so the result is exact.
+  const auto pixels = overview.query(4096, 4096 * 40, 40);
+  ASSERT_EQ(pixels.size(), 40);
+  for (size_t pixel = 0; pixel < pixels.size(); pixel++) {
+    const size_t first = 4096 * (pixel + 1);
+    const auto expected = summarize(samples, first, first + 4096);
+    EXPECT_EQ(pixels[pixel].min, expected.min);
+    EXPECT_EQ(pixels[pixel].max, expected.max);
+    EXPECT_NEAR(pixels[pixel].rms, expected.rms, expected.rms * 1e-4);
+  }
+
+  // The whole file in one pixel, including the partial last bucket.
+  const auto all = overview.query(0, UINT32_MAX, 1);
+  ASSERT_EQ(all.size(), 1);
+  const auto expected = summarize(samples, 0, samples.size());
+  EXPECT_EQ(all[0].min, expected.min);
+  EXPECT_EQ(all[0].max, expected.max);
+  EXPECT_NEAR(all[0].rms, expected.rms, expected.rms * 1e-4);
+
+  EXPECT_TRUE(overview.query(samples.size(), 100, 10).empty());
+}
+
+TEST_F(OverviewTest, WriterSidecarMatchesParallelBuild) {
+  const auto samples = makeSamples(65536 * 5 + 77);
+  {
+    wavgen::Writer writer(kTestFileName);
+    writer.enableOverview();
+    writer.addSamples(samples.data(), samples.size());
+  }
+  ASSERT_TRUE(
+      std::filesystem::exists(wavgen::Overview::sidecarPath(kTestFileName)));
+
+  const auto built = wavgen::Overview::build(kTestFileName, 3);
+  const auto loaded = wavgen::Overview::loadSidecar(kTestFileName);
+  ASSERT_EQ(built.getNumSamples(), samples.size());
+  ASSERT_EQ(loaded.getNumSamples(), samples.size());
+
+  for (uint32_t num_pixels : {1U, 7U, 100U, 2000U}) {
+    const auto a = built.query(0, samples.size(), num_pixels);
+    const auto b = loaded.query(0, samples.size(), num_pixels);
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+      EXPECT_EQ(a[i].min, b[i].min);
+      EXPECT_EQ(a[i].max, b[i].max);
+      EXPECT_FLOAT_EQ(a[i].rms, b[i].rms);
+    }
+  }
+
+  // The reader uses the sidecar, or builds the same overview without it.
+  wavgen::Reader reader(kTestFileName);
+  EXPECT_EQ(reader.getOverview().getNumSamples(), samples.size());
+  std::filesystem::remove(wavgen::Overview::sidecarPath(kTestFileName));
+  wavgen::Reader second_reader(kTestFileName);
+  const auto pixels = second_reader.getOverview(2).query(0, 65536, 1);
+  const auto expected = summarize(samples, 0, 65536);
+  EXPECT_EQ(pixels[0].min, expected.min);
+  EXPECT_EQ(pixels[0].max, expected.max);
+}
+
+TEST_F(OverviewTest, RejectsStaleSidecars) {
+  const std::vector<int16_t> samples(100000, 1000);
+  {
+    wavgen::Writer writer(kTestFileName);
+    writer.enableOverview();
+    writer.addSamples(samples.data(), samples.size());
+  }
+  EXPECT_NO_THROW(wavgen::Overview::loadSidecar(kTestFileName));
+
+  // Modified without changing the size.
+  const auto modified = std::filesystem::last_write_time(kTestFileName);
+  std::filesystem::last_write_time(kTestFileName,
+                                   modified + std::chrono::seconds(1));
+  EXPECT_THROW(wavgen::Overview::loadSidecar(kTestFileName),
+               std::runtime_error);
+  std::filesystem::last_write_time(kTestFileName, modified);
+  EXPECT_NO_THROW(wavgen::Overview::loadSidecar(kTestFileName));
+
+  // Normalizing removes the sidecar, the reader sees the new levels.
+  wavgen::normalize(kTestFileName);
+  EXPECT_FALSE(
+      std::filesystem::exists(wavgen::Overview::sidecarPath(kTestFileName)));
+  wavgen::Reader reader(kTestFileName);
+  EXPECT_EQ(reader.getOverview().query(0, samples.size(), 1)[0].max,
+            wavgen::MAX_SAMPLE_AMPLITUDE);
+}
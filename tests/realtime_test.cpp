@@ -0,0 +1,145 @@
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_realtime.hpp"
+
+const std::string kTestFileName = "test.wav";
+
+class RealtimeGeneratorTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    // Delete the file if it exists.
+    if (std::filesystem::exists(kTestFileName)) {
+      std::filesystem::remove(kTestFileName);
+    }
+    // Assert that the file does not exist.
+    ASSERT_FALSE(std::filesystem::exists(kTestFileName));
+  }
+
+  void TearDown() override {
+    // Delete the file if it exists.
+    if (std::filesystem::exists(kTestFileName)) {
+      std::filesystem::remove(kTestFileName);
+    }
+  }
+};
+
+TEST_F(RealtimeGeneratorTest, RendersQueuedTonesThenSilence) {
+  wavgen::RealtimeGenerator generator;
+  ASSERT_TRUE(generator.queueSineWave(1000, 1.0, 100));
+  ASSERT_TRUE(generator.queueSilence(50));
+  ASSERT_TRUE(generator.queueSineWave(2000, 0.5, 100));
+  EXPECT_EQ(generator.getQueuedSamples(), 250);
+
+  std::vector<int16_t> block(64);
+  std::vector<int16_t> output;
+  for (int i = 0; i < 5; i++) {
+    generator.render(block.data(), block.size());
+    output.insert(output.end(), block.begin(), block.end());
+  }
+
+  // Tone, silence, tone, then silence once the queue runs dry.
+  EXPECT_NE(output[10], 0);
+  for (size_t i = 100; i < 150; i++) {
+    ASSERT_EQ(output[i], 0) << "Sample " << i;
+  }
+  EXPECT_NE(output[160], 0);
+  for (size_t i = 250; i < output.size(); i++) {
+    ASSERT_EQ(output[i], 0) << "Sample " << i;
+  }
+
+  const auto stats = generator.getStats();
+  EXPECT_EQ(stats.blocks_rendered, 5);
+  EXPECT_EQ(stats.samples_rendered, 320);
+  EXPECT_EQ(stats.underrun_samples, 70);
+  EXPECT_GE(stats.worst_render_time, stats.last_render_time);
+  EXPECT_EQ(generator.getQueuedSamples(), 0);
+}
+
+TEST_F(RealtimeGeneratorTest, CallbackMatchesRender) {
+  wavgen::RealtimeGenerator direct;
+  wavgen::RealtimeGenerator callback;
+  direct.queueSineWave(440.5, 0.8, 1000);
+  callback.queueSineWave(440.5, 0.8, 1000);
+
+  std::vector<int16_t> expected(1000);
+  std::vector<int16_t> actual(1000);
+  direct.render(expected.data(), 1000);
+  for (uint32_t i = 0; i < 1000; i += 100) {
+    wavgen::RealtimeGenerator::renderCallback(&callback, actual.data() + i,
+                                              100);
+  }
+  EXPECT_EQ(expected, actual);
+}
+
+TEST_F(RealtimeGeneratorTest, RecordsRenderedAudio) {
+  constexpr uint32_t kBlockSize = 480;
+  constexpr uint32_t kNumBlocks = 20;
+
+  std::vector<int16_t> rendered;
+  {
+    wavgen::Writer writer(kTestFileName);
+    wavgen::RealtimeGenerator generator;
+    generator.queueSineWave(1200, 0.5, kBlockSize * kNumBlocks / 2);
+    generator.queueSineWave(2200, 0.5, kBlockSize * kNumBlocks / 2);
+    generator.startRecording(writer);
+
+    std::vector<int16_t> block(kBlockSize);
+    for (uint32_t i = 0; i < kNumBlocks; i++) {
+      generator.render(block.data(), kBlockSize);
+      rendered.insert(rendered.end(), block.begin(), block.end());
+    }
+    generator.stopRecording();
+    EXPECT_EQ(generator.getStats().dropped_recording_samples, 0);
+    writer.done();
+  }
+
+  std::vector<int16_t> recorded;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(recorded);
+  EXPECT_EQ(recorded, rendered);
+}
+
+TEST_F(RealtimeGeneratorTest, RecordingUsesTheRequestedBufferSize) {
+  wavgen::RealtimeGenerator generator;
+  std::vector<int16_t> block(1000);
+  {
+    wavgen::Writer writer(kTestFileName);
+    generator.startRecording(writer, 64);
+    generator.render(block.data(), block.size());
+    generator.stopRecording();
+  }
+  EXPECT_EQ(generator.getStats().dropped_recording_samples, 1000 - 64);
+
+  generator.resetStats();
+  {
+    wavgen::Writer writer(kTestFileName);
+    generator.startRecording(writer, 4096);
+    generator.render(block.data(), block.size());
+    generator.stopRecording();
+  }
+  EXPECT_EQ(generator.getStats().dropped_recording_samples, 0);
+}
+
+TEST_F(RealtimeGeneratorTest, FullQueueAndResetKeepCountsConsistent) {
+  wavgen::RealtimeGenerator generator(4);
+  uint64_t queued = 0;
+  while (generator.queueSineWave(1000, 0.5, 10)) {
+    queued += 10;
+  }
+  EXPECT_GT(queued, 0);
+  EXPECT_EQ(generator.getQueuedSamples(), queued);
+
+  std::vector<int16_t> block(64);
+  generator.render(block.data(), block.size());
+  generator.render(block.data(), block.size());
+  EXPECT_EQ(generator.getStats().blocks_rendered, 2);
+
+  // The audio thread applies the reset when it renders the next block.
+  generator.resetStats();
+  generator.render(block.data(), block.size());
+  const auto stats = generator.getStats();
+  EXPECT_EQ(stats.blocks_rendered, 1);
+  EXPECT_EQ(stats.samples_rendered, 64);
+}
@@ -0,0 +1,127 @@
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+#include "wav_gen.hpp"
+#include "wav_tools.hpp"
+
+const std::string kTestFileName = "test.wav";
+const std::string kCrashedFileName = "crashed.wav";
+
+class RecoverTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    TearDown();
+    ASSERT_FALSE(std::filesystem::exists(kTestFileName));
+    ASSERT_FALSE(std::filesystem::exists(kCrashedFileName));
+  }
+
+  void TearDown() override {
+    for (const auto &file : {kTestFileName, kCrashedFileName}) {
+      if (std::filesystem::exists(file)) {
+        std::filesystem::remove(file);
+      }
+    }
+  }
+};
+
+TEST_F(RecoverTest, RecoversUnfinishedFile) {
+  std::vector<int16_t> samples(wavgen::WRITER_BUFFER_SIZE * 3);
+  for (size_t i = 0; i < samples.size(); i++) {
+    samples[i] = static_cast<int16_t>(i);
+  }
+
+  wavgen::Writer writer(kTestFileName);
+  writer.addSamples(samples.data(), samples.size());
+
+  // Copy the file while it is still being written, as it would be found
+  // after a crash. Add half a sample to the end.
+  std::filesystem::copy_file(kTestFileName, kCrashedFileName);
+  {
+    std::ofstream crashed(kCrashedFileName, std::ios::binary | std::ios::app);
+    crashed.put('x');
+  }
+  writer.done();
+
+  const auto result = wavgen::recoverFile(kCrashedFileName);
+  EXPECT_FALSE(result.was_consistent);
+  EXPECT_EQ(result.num_samples, samples.size());
+  EXPECT_EQ(result.bytes_truncated, 1);
+
+  wavgen::Reader reader(kCrashedFileName);
+  EXPECT_EQ(reader.getNumSamples(), samples.size());
+  std::vector<int16_t> recovered;
+  reader.getAllSamples(recovered);
+  EXPECT_EQ(recovered, samples);
+}
+
+TEST_F(RecoverTest, RecoversStereoFileFromCheckpoint) {
+  // Two buffers of frames, each one is written when it fills up.
+  constexpr uint32_t kFrames = wavgen::WRITER_BUFFER_SIZE;
+  constexpr uint32_t kHalf = kFrames / 2;
+  std::vector<int16_t> left(kFrames);
+  std::vector<int16_t> right(kFrames);
+  for (uint32_t i = 0; i < kFrames; i++) {
+    left[i] = static_cast<int16_t>(i);
+    right[i] = static_cast<int16_t>(-i);
+  }
+  const int16_t *const first[] = {left.data(), right.data()};
+  const int16_t *const second[] = {left.data() + kHalf, right.data() + kHalf};
+
+  const int fd = ::open(kTestFileName.c_str(), O_RDWR | O_CREAT, 0644);
+  ASSERT_GE(fd, 0);
+  {
+    wavgen::Writer writer;
+    writer.setNumChannels(2);
+    writer.open(fd);
+    writer.addFrames(first, kHalf);
+    writer.checkpoint();
+    writer.addFrames(second, kHalf);
+
+    // The header only covers the first half. Then a frame and a half is
+    // left at the end.
+    std::filesystem::copy_file(kTestFileName, kCrashedFileName);
+  }
+  ::close(fd);
+  {
+    std::ofstream crashed(kCrashedFileName, std::ios::binary | std::ios::app);
+    crashed.write("abcdef", 6);
+  }
+
+  const auto result = wavgen::recoverFile(kCrashedFileName);
+  EXPECT_FALSE(result.was_consistent);
+  EXPECT_EQ(result.num_samples, kFrames + 1);
+  EXPECT_EQ(result.bytes_truncated, 2);
+
+  wavgen::Reader reader(kCrashedFileName);
+  EXPECT_EQ(reader.getFormat().num_channels, 2);
+  EXPECT_EQ(reader.getNumSamples(), kFrames + 1);
+  std::vector<int16_t> recovered_left(kFrames);
+  std::vector<int16_t> recovered_right(kFrames);
+  int16_t *const outputs[] = {recovered_left.data(), recovered_right.data()};
+  EXPECT_EQ(reader.readPlanar(outputs, 0, kFrames), kFrames);
+  EXPECT_EQ(recovered_left, left);
+  EXPECT_EQ(recovered_right, right);
+}
+
+TEST_F(RecoverTest, LeavesFinishedFileUnchanged) {
+  {
+    wavgen::Generator generator(kTestFileName);
+    generator.addSineWave(1000, 0.5, 100);
+  }
+  const auto result = wavgen::recoverFile(kTestFileName);
+  EXPECT_TRUE(result.was_consistent);
+  EXPECT_EQ(result.num_samples, wavgen::SAMPLE_RATE_MS * 100);
+  EXPECT_EQ(result.bytes_truncated, 0);
+}
+
+TEST_F(RecoverTest, RejectsShortFile) {
+  {
+    std::ofstream file(kTestFileName, std::ios::binary);
+    file << "RIFF";
+  }
+  EXPECT_THROW(wavgen::recoverFile(kTestFileName), std::runtime_error);
+}
@@ -0,0 +1,163 @@
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_gen.hpp"
+#include "wav_sstv.hpp"
+
+const std::string kTestFileName = "test.wav";
+
+class SstvTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    if (std::filesystem::exists(kTestFileName)) {
+      std::filesystem::remove(kTestFileName);
+    }
+  }
+
+  void TearDown() override {
+    if (std::filesystem::exists(kTestFileName)) {
+      std::filesystem::remove(kTestFileName);
+    }
+  }
+
+  std::vector<int16_t> readSamples() {
+    std::vector<int16_t> samples;
+    wavgen::Reader reader(kTestFileName);
+    reader.getAllSamples(samples);
+    return samples;
+  }
+
+  /**
+   * @brief Estimate the frequency between two times in milliseconds from the
+   * number of zero crossings.
+   */
+  static double measureFrequency(const std::vector<int16_t> &samples,
+                                 double start_ms, double end_ms) {
+    const auto first = static_cast<size_t>(start_ms * wavgen::SAMPLE_RATE_MS);
+    const auto last = static_cast<size_t>(end_ms * wavgen::SAMPLE_RATE_MS);
+    int crossings = 0;
+    for (size_t i = first + 1; i < last; i++) {
+      if ((samples[i - 1] < 0) != (samples[i] < 0)) {
+        crossings++;
+      }
+    }
+    return crossings * 1000.0 / (2.0 * (end_ms - start_ms));
+  }
+};
+
+TEST_F(SstvTest, SendsTheVisCode) {
+  for (auto mode : {wavgen::SstvMode::ROBOT_36, wavgen::SstvMode::ROBOT_72,
+                    wavgen::SstvMode::MARTIN_1, wavgen::SstvMode::MARTIN_2,
+                    wavgen::SstvMode::SCOTTIE_1,
+                    wavgen::SstvMode::SCOTTIE_2}) {
+    wavgen::SstvEncoder encoder(mode);
+    {
+      wavgen::Writer writer(kTestFileName);
+      encoder.addHeader(writer);
+    }
+    const std::vector<int16_t> samples = readSamples();
+    ASSERT_EQ(samples.size(), 910 * wavgen::SAMPLE_RATE_MS);
+    EXPECT_NEAR(measureFrequency(samples, 10, 290), 1900, 10);
+    EXPECT_NEAR(measureFrequency(samples, 612, 638), 1200, 40);
+
+    // Bits start after the 30 ms start bit, 1100 Hz is a one.
+    int code = 0;
+    int ones = 0;
+    for (int bit = 0; bit < 8; bit++) {
+      const double start_ms = 640.0 + bit * 30.0;
+      const double frequency =
+          measureFrequency(samples, start_ms + 2, start_ms + 28);
+      const bool one = frequency < 1200.0;
+      EXPECT_NEAR(frequency, one ? 1100 : 1300, 40);
+      code |= (one && bit < 7) ? 1 << bit : 0;
+      ones += one;
+    }
+    EXPECT_EQ(code, encoder.getModeInfo().vis_code);
+    EXPECT_EQ(ones % 2, 0); // Even parity.
+  }
+}
+
+TEST_F(SstvTest, ScansPixelFrequencies) {
+  wavgen::SstvEncoder encoder(wavgen::SstvMode::MARTIN_1);
+  const wavgen::SstvModeInfo info = encoder.getModeInfo();
+  std::vector<uint8_t> line(info.width * 3, 0);
+  for (uint16_t i = 0; i < info.width; i++) {
+    line[i * 3 + 1] = 255; // Green is white, red and blue are black.
+  }
+  {
+    wavgen::Writer writer(kTestFileName);
+    encoder.addHeader(writer);
+    encoder.addLine(writer, line.data());
+  }
+  const std::vector<int16_t> samples = readSamples();
+
+  // Sync, porch, then green, blue and red scans of 146.432 ms.
+  const double sync_ms = 910.0;
+  const double green_ms = sync_ms + 4.862 + 0.572;
+  const double blue_ms = green_ms + 146.432 + 0.572;
+  EXPECT_NEAR(measureFrequency(samples, sync_ms + 0.5, sync_ms + 4.5), 1200,
+              150);
+  EXPECT_NEAR(measureFrequency(samples, green_ms + 5, green_ms + 140), 2300,
+              10);
+  EXPECT_NEAR(measureFrequency(samples, blue_ms + 5, blue_ms + 140), 1500,
+              10);
+}
+
+TEST_F(SstvTest, ImageHasExactLengthAndContinuousPhase) {
+  wavgen::SstvEncoder encoder(wavgen::SstvMode::ROBOT_36);
+  const wavgen::SstvModeInfo info = encoder.getModeInfo();
+  EXPECT_EQ(info.width, 320);
+  EXPECT_EQ(info.height, 240);
+  EXPECT_EQ(info.line_duration.numerator, 3);
+  EXPECT_EQ(info.line_duration.denominator, 20); // 150 ms
+
+  std::vector<uint8_t> image(info.width * info.height * 3);
+  for (size_t i = 0; i < image.size(); i++) {
+    image[i] = static_cast<uint8_t>(i * 7);
+  }
+  {
+    wavgen::Generator generator(kTestFileName);
+    encoder.addImage(generator, image.data(), image.size());
+  }
+  const std::vector<int16_t> samples = readSamples();
+  EXPECT_EQ(samples.size(), (910 + 150 * 240) * wavgen::SAMPLE_RATE_MS);
+
+  // The largest step of a continuous 2300 Hz sine, anything more would be a
+  // phase jump between pixels.
+  const double max_step = 0.5 * wavgen::MAX_SAMPLE_AMPLITUDE * 2 * M_PI *
+                          2300.0 / wavgen::SAMPLE_RATE;
+  for (size_t i = 1; i < samples.size(); i++) {
+    ASSERT_LE(std::abs(samples[i] - samples[i - 1]), max_step + 4) << i;
+  }
+}
+
+TEST_F(SstvTest, ScottieStartsWithASyncPulse) {
+  wavgen::SstvEncoder encoder(wavgen::SstvMode::SCOTTIE_1);
+  const wavgen::SstvModeInfo info = encoder.getModeInfo();
+  std::vector<uint8_t> line(info.width * 3, 128);
+  {
+    wavgen::Writer writer(kTestFileName);
+    encoder.addHeader(writer);
+    encoder.addLine(writer, line.data());
+    encoder.addLine(writer, line.data());
+  }
+  // 428.22 ms per line, plus the 9 ms sync pulse before the first one.
+  const double expected = (910 + 9 + 2 * 428.22) * wavgen::SAMPLE_RATE_MS;
+  EXPECT_NEAR(readSamples().size(), expected, 1);
+}
+
+TEST_F(SstvTest, RejectsImagesOfTheWrongSize) {
+  wavgen::SstvEncoder encoder(wavgen::SstvMode::MARTIN_2);
+  wavgen::Writer writer(kTestFileName);
+  std::vector<uint8_t> image(320 * 240 * 3);
+  EXPECT_THROW(encoder.addImage(writer, image.data(), image.size()),
+               std::runtime_error);
+
+  image.resize(320 * 256 * 3);
+  encoder.addImage(writer, image.data(), image.size());
+  EXPECT_THROW(encoder.addLine(writer, image.data()), std::runtime_error);
+  writer.done();
+}
@@ -0,0 +1,91 @@
+#include <array>
+#include <cmath>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "wav_gen.hpp"
+#include "wav_timeline.hpp"
+
+const std::string kTestFileName = "test.wav";
+
+TEST(TimelineTest, CarriesFractionalSamples) {
+  // At 48 kHz a 7000 baud symbol is 6.857 samples long.
+  wavgen::Timeline timeline;
+  constexpr uint64_t kSymbols = 7000;
+  for (uint64_t i = 0; i < kSymbols; i++) {
+    timeline.addTone(i % 2 == 0 ? 1200.0 : 2200.0, 0.5,
+                     wavgen::Duration::seconds(1, 7000));
+  }
+  // Exactly one second, where rounding each symbol to 7 samples would give
+  // 49000 samples and truncating to 6 would give 42000.
+  EXPECT_EQ(timeline.getNumSamples(), wavgen::SAMPLE_RATE);
+  EXPECT_EQ(timeline.getCursor().numerator, 1);
+  EXPECT_EQ(timeline.getCursor().denominator, 1);
+
+  timeline.addSilence(wavgen::Duration::milliseconds(1));
+  timeline.addTone(1000.0, 0.5, wavgen::Duration::samples(5));
+  EXPECT_EQ(timeline.getNumSamples(),
+            wavgen::SAMPLE_RATE + wavgen::SAMPLE_RATE_MS + 5);
+}
+
+TEST(TimelineTest, RendersSegmentsIntoOneBlock) {
+  wavgen::Timeline timeline;
+  timeline.addSilence(wavgen::Duration::samples(10));
+  timeline.addTone(1000.0, 0.5, wavgen::Duration::samples(100));
+  timeline.addSilence(wavgen::Duration::samples(10));
+  timeline.addTone(2000.0, 0.5, wavgen::Duration::samples(100));
+
+  std::vector<int16_t> block(1000, 1);
+  EXPECT_EQ(timeline.render(block.data(), block.size()), 220);
+  EXPECT_EQ(timeline.getRemainingSamples(), 0);
+  EXPECT_EQ(timeline.render(block.data(), block.size()), 0);
+
+  // Tones continue the phase over the silence.
+  double angle = 0.0;
+  for (uint32_t i = 0; i < 220; i++) {
+    if (i < 10 || (i >= 110 && i < 120)) {
+      EXPECT_EQ(block[i], 0) << i;
+      continue;
+    }
+    angle += 2 * M_PI * (i < 110 ? 1000.0 : 2000.0) / wavgen::SAMPLE_RATE;
+    const double expected =
+        0.5 * std::sin(angle) * wavgen::MAX_SAMPLE_AMPLITUDE;
+    EXPECT_NEAR(block[i], expected, 2.0) << i;
+  }
+}
+
+TEST(TimelineTest, RendersToWriterInAnyBlockSize) {
+  wavgen::Timeline timeline;
+  for (int i = 0; i < 50; i++) {
+    timeline.addTone(500.0 + i * 10, 0.3, wavgen::Duration::seconds(1, 300));
+  }
+  std::vector<int16_t> small_blocks;
+  std::array<int16_t, 37> block;
+  uint32_t count = 0;
+  while ((count = timeline.render(block.data(), block.size())) > 0) {
+    small_blocks.insert(small_blocks.end(), block.begin(),
+                        block.begin() + count);
+  }
+
+  timeline.clear();
+  for (int i = 0; i < 50; i++) {
+    timeline.addTone(500.0 + i * 10, 0.3, wavgen::Duration::seconds(1, 300));
+  }
+  {
+    wavgen::Writer writer(kTestFileName);
+    timeline.renderTo(writer);
+  }
+  std::vector<int16_t> samples;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(samples);
+  std::filesystem::remove(kTestFileName);
+
+  // The oscillator restarts from the exact phase at each block, so the
+  // block size only changes float rounding.
+  ASSERT_EQ(samples.size(), 50 * wavgen::SAMPLE_RATE / 300);
+  ASSERT_EQ(samples.size(), small_blocks.size());
+  for (size_t i = 0; i < samples.size(); i++) {
+    EXPECT_NEAR(samples[i], small_blocks[i], 2) << i;
+  }
+}
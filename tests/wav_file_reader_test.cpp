@@ -1,4 +1,6 @@
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 
 #include "gtest/gtest.h"
 
@@ -106,4 +108,170 @@ TEST_F(WavFileReaderTest, GetAllSamples) {
   for (uint32_t i = 0; i < samples.size(); i++) {
     EXPECT_EQ(samples[i], kTestSamples[i]) << "Sample " << i << " is incorrect";
   }
-}
\ No newline at end of file
+}
+
+namespace {
+
+/**
+ * @brief Write a WAV file of any format, with a LIST chunk before the data
+ * chunk as other programs write them.
+ */
+void writeWavFile(const std::string &path, uint16_t format_code,
+                  uint16_t num_channels, uint16_t bits_per_sample,
+                  const std::vector<uint8_t> &data) {
+  std::vector<uint8_t> bytes;
+  auto put = [&bytes](uint32_t value, size_t num_bytes) {
+    for (size_t i = 0; i < num_bytes; i++) {
+      bytes.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+  };
+  auto putId = [&bytes](const std::string &id) {
+    bytes.insert(bytes.end(), id.begin(), id.end());
+  };
+  const uint16_t block_align = num_channels * bits_per_sample / 8;
+
+  putId("RIFF");
+  put(0, 4); // Not checked by the reader.
+  putId("WAVE");
+  putId("fmt ");
+  put(16, 4);
+  put(format_code, 2);
+  put(num_channels, 2);
+  put(48000, 4);
+  put(48000 * block_align, 4);
+  put(block_align, 2);
+  put(bits_per_sample, 2);
+  putId("LIST");
+  put(3, 4);
+  putId("abc");
+  bytes.push_back(0); // Padding to an even size.
+  putId("data");
+  put(static_cast<uint32_t>(data.size()), 4);
+  bytes.insert(bytes.end(), data.begin(), data.end());
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+
+} // namespace
+
+TEST_F(WavFileReaderTest, DecodesIntegerFormats) {
+  // The same four values, -1.0, -0.5, 0.0 and 0.5, in every integer format.
+  const std::vector<std::pair<uint16_t, std::vector<uint8_t>>> kFiles = {
+      {8, {0x00, 0x40, 0x80, 0xC0}},
+      {16, {0x00, 0x80, 0x00, 0xC0, 0x00, 0x00, 0x00, 0x40}},
+      {24, {0x00, 0x00, 0x80, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x40}},
+      {32, {0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x40}}};
+
+  for (const auto &[bits, data] : kFiles) {
+    writeWavFile(kTestFileName, 1, 1, bits, data);
+    wavgen::Reader reader(kTestFileName);
+    EXPECT_EQ(reader.getNumSamples(), 4);
+    EXPECT_EQ(reader.getBitsPerSample(), bits);
+    EXPECT_EQ(reader.getSampleRate(), 48000);
+
+    std::vector<float> samples(4);
+    EXPECT_EQ(reader.read(samples.data(), 0, 4), 4);
+    EXPECT_EQ(samples, std::vector<float>({-1.0f, -0.5f, 0.0f, 0.5f}))
+        << bits << " bits";
+
+    std::vector<double> tail(4);
+    EXPECT_EQ(reader.read(tail.data(), 2, 4), 2); // Stops at the end.
+    EXPECT_EQ(tail[0], 0.0);
+    EXPECT_EQ(tail[1], 0.5);
+  }
+}
+
+TEST_F(WavFileReaderTest, DecodesFloatAndDownmixes) {
+  const std::vector<float> kFrames = {0.5f, -0.25f, 1.0f, 0.0f, -1.0f, -0.5f};
+  std::vector<uint8_t> data(kFrames.size() * sizeof(float));
+  std::memcpy(data.data(), kFrames.data(), data.size());
+  writeWavFile(kTestFileName, 3, 2, 32, data);
+
+  wavgen::Reader reader(kTestFileName);
+  EXPECT_EQ(reader.getFormat().sample_format, wavgen::SampleFormat::FLOAT_32);
+  EXPECT_EQ(reader.getFormat().num_channels, 2);
+  EXPECT_EQ(reader.getNumSamples(), 3);
+
+  std::vector<float> interleaved(6);
+  reader.read(interleaved.data(), 0, 3, wavgen::ChannelMode::INTERLEAVED);
+  EXPECT_EQ(interleaved, kFrames);
+
+  std::vector<double> mono(3);
+  reader.read(mono.data(), 0, 3, wavgen::ChannelMode::DOWNMIX);
+  EXPECT_EQ(mono, std::vector<double>({0.125, 0.5, -0.75}));
+
+  std::vector<int16_t> samples;
+  EXPECT_THROW(reader.getAllSamples(samples), std::runtime_error);
+}
+
+TEST_F(WavFileReaderTest, ReadsFloatFromGeneratedFile) {
+  std::vector<int16_t> kSamples(wavgen::WRITER_BUFFER_SIZE + 3);
+  for (size_t i = 0; i < kSamples.size(); i++) {
+    kSamples[i] = static_cast<int16_t>(i * 7 - 16000);
+  }
+  {
+    wavgen::Writer writer(kTestFileName);
+    writer.addSamples(kSamples.data(), kSamples.size());
+  }
+
+  wavgen::Reader reader(kTestFileName);
+  std::vector<float> samples(kSamples.size());
+  ASSERT_EQ(reader.read(samples.data(), 0, samples.size()), kSamples.size());
+  for (size_t i = 0; i < samples.size(); i++) {
+    ASSERT_EQ(samples[i], kSamples[i] / 32768.0f) << i;
+  }
+}
+
+TEST_F(WavFileReaderTest, StreamsBlocks) {
+  constexpr uint32_t kBlockSize = 1000;
+  std::vector<int16_t> kSamples(kBlockSize * 3 + 17);
+  for (size_t i = 0; i < kSamples.size(); i++) {
+    kSamples[i] = static_cast<int16_t>(i);
+  }
+  {
+    wavgen::Writer writer(kTestFileName);
+    writer.addSamples(kSamples.data(), kSamples.size());
+  }
+
+  wavgen::Reader reader(kTestFileName);
+  std::vector<int16_t> samples;
+  uint32_t num_blocks = 0;
+  const int16_t *buffer = nullptr;
+  for (const auto &block : reader.blocks(kBlockSize)) {
+    EXPECT_EQ(block.first_sample, samples.size());
+    EXPECT_LE(block.size(), kBlockSize);
+    if (buffer != nullptr) {
+      EXPECT_EQ(block.samples, buffer); // The buffer is reused.
+    }
+    buffer = block.samples;
+    samples.insert(samples.end(), block.begin(), block.end());
+    num_blocks++;
+  }
+  EXPECT_EQ(num_blocks, 4);
+  EXPECT_EQ(samples, kSamples);
+
+  int64_t sum = 0;
+  reader.visitBlocks(
+      [&sum](const wavgen::SampleBlock &block) {
+        for (int16_t sample : block) {
+          sum += sample;
+        }
+      },
+      256);
+  const auto n = static_cast<int64_t>(kSamples.size());
+  EXPECT_EQ(sum, n * (n - 1) / 2);
+}
+
+TEST_F(WavFileReaderTest, StreamsEmptyFile) {
+  { wavgen::Writer writer(kTestFileName); }
+  wavgen::Reader reader(kTestFileName);
+  uint32_t num_blocks = 0;
+  for (const auto &block : reader.blocks()) {
+    (void)block;
+    num_blocks++;
+  }
+  EXPECT_EQ(num_blocks, 0);
+}
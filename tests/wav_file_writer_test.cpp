@@ -1,9 +1,14 @@
+#include <array>
+#include <fcntl.h>
 #include <filesystem>
+#include <unistd.h>
 
 #include "gtest/gtest.h"
 
 #include "file.hpp"
+#include "wav_filter.hpp"
 #include "wav_gen.hpp"
+#include "wav_overview.hpp"
 
 const std::string kTestFileName = "test.wav";
 const uint32_t HEADER_SIZE = 44;
@@ -106,4 +111,220 @@ TEST_F(WavFileWriterTest, HeaderSavedCorrectly) {
   ASSERT_EQ(std::filesystem::file_size(kTestFileName), kExpectedFileSize);
   ASSERT_EQ(header.data_chunk_size, kNumSamplesToAdd * kBytesPerSample);
   ASSERT_EQ(header.file_size, kExpectedFileSize - 8);
-}
\ No newline at end of file
+}
+
+TEST_F(WavFileWriterTest, ReopenWritesNewFile) {
+  const std::string kSecondFileName = "test2.wav";
+
+  wavgen::Writer wav_file;
+  EXPECT_FALSE(wav_file.isOpen());
+  wav_file.open(kTestFileName);
+  for (int i = 0; i < 100; i++) {
+    wav_file.addSample(static_cast<int16_t>(i));
+  }
+
+  // Opening another file finishes the first one.
+  wav_file.open(kSecondFileName);
+  EXPECT_TRUE(wav_file.isOpen());
+  EXPECT_EQ(wav_file.getNumSamples(), 0);
+  wav_file.addSample(static_cast<int16_t>(1));
+  wav_file.done();
+  EXPECT_FALSE(wav_file.isOpen());
+
+  ASSERT_EQ(std::filesystem::file_size(kTestFileName), HEADER_SIZE + 200);
+  ASSERT_EQ(std::filesystem::file_size(kSecondFileName), HEADER_SIZE + 2);
+  wavgen::Reader reader(kTestFileName);
+  EXPECT_EQ(reader.getNumSamples(), 100);
+  std::filesystem::remove(kSecondFileName);
+}
+
+TEST_F(WavFileWriterTest, MovedWriterKeepsWriting) {
+  wavgen::Writer first(kTestFileName);
+  first.addSample(static_cast<int16_t>(1));
+
+  wavgen::Writer second(std::move(first));
+  EXPECT_FALSE(first.isOpen());
+  second.addSample(static_cast<int16_t>(2));
+  EXPECT_EQ(second.getNumSamples(), 2);
+  second.done();
+
+  std::vector<int16_t> samples;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(samples);
+  EXPECT_EQ(samples, std::vector<int16_t>({1, 2}));
+}
+
+TEST_F(WavFileWriterTest, CheckpointUpdatesHeaderWhileWriting) {
+  wavgen::Writer writer(kTestFileName);
+  writer.setCheckpointPolicy({wavgen::WRITER_BUFFER_SIZE * 2, 0});
+
+  std::vector<int16_t> samples(wavgen::WRITER_BUFFER_SIZE * 2 + 10, 7);
+  writer.addSamples(samples.data(), samples.size());
+
+  // Two buffers have been written, the last 10 samples are still buffered.
+  auto header = wavgen::readHeader(kTestFileName);
+  EXPECT_EQ(header.data_chunk_size, wavgen::WRITER_BUFFER_SIZE * 2 * 2);
+  EXPECT_EQ(header.file_size, header.data_chunk_size + HEADER_SIZE - 8);
+  EXPECT_EQ(std::filesystem::file_size(kTestFileName),
+            HEADER_SIZE + header.data_chunk_size);
+
+  writer.checkpoint(); // Does not write the buffered samples.
+  EXPECT_EQ(std::filesystem::file_size(kTestFileName),
+            HEADER_SIZE + wavgen::WRITER_BUFFER_SIZE * 2 * 2);
+
+  writer.done();
+  header = wavgen::readHeader(kTestFileName);
+  EXPECT_EQ(header.data_chunk_size, samples.size() * 2);
+}
+
+TEST_F(WavFileWriterTest, CallerBufferAndFileDescriptor) {
+  std::array<int16_t, 3> buffer{};
+  wavgen::Writer writer(buffer.data(), buffer.size());
+  const int fd = ::open(kTestFileName.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+                        0644);
+  ASSERT_GE(fd, 0);
+  writer.open(fd);
+  for (int16_t i = 0; i < 10; i++) {
+    writer.addSample(i);
+  }
+  writer.done();
+  EXPECT_EQ(writer.getStatus(), wavgen::Status::OK);
+
+  // The writer does not own the descriptor.
+  EXPECT_EQ(::close(fd), 0);
+
+  std::vector<int16_t> samples;
+  wavgen::Reader reader(kTestFileName);
+  reader.getAllSamples(samples);
+  EXPECT_EQ(samples, std::vector<int16_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+TEST_F(WavFileWriterTest, ErrorsSetTheStatus) {
+  wavgen::Writer writer;
+  EXPECT_EQ(writer.getStatus(), wavgen::Status::OK);
+  EXPECT_THROW(writer.open("missing_directory/test.wav"), std::runtime_error);
+  EXPECT_EQ(writer.getStatus(), wavgen::Status::OPEN_FAILED);
+
+  writer.clearStatus();
+  EXPECT_EQ(writer.getStatus(), wavgen::Status::OK);
+
+  // The header can not be written to a full device, the descriptor opened
+  // for it is closed again.
+  auto count_fds = [] {
+    const std::filesystem::directory_iterator fds("/proc/self/fd");
+    return std::distance(begin(fds), end(fds));
+  };
+  const auto num_fds = count_fds();
+  EXPECT_THROW(writer.open("/dev/full"), std::runtime_error);
+  EXPECT_EQ(writer.getStatus(), wavgen::Status::WRITE_FAILED);
+  EXPECT_FALSE(writer.isOpen());
+  EXPECT_EQ(count_fds(), num_fds);
+}
+
+TEST_F(WavFileWriterTest, HeaderIsBuiltAtCompileTime) {
+  constexpr auto kHeader = wavgen::packHeader(wavgen::makeHeader(10 * 2));
+  static_assert(kHeader[0] == 'R' && kHeader[40] == 20);
+
+  wavgen::Writer writer(kTestFileName);
+  for (int16_t i = 0; i < 10; i++) {
+    writer.addSample(i);
+  }
+  writer.done();
+
+  std::array<char, HEADER_SIZE> bytes{};
+  std::ifstream file(kTestFileName, std::ios::binary);
+  file.read(bytes.data(), bytes.size());
+  EXPECT_TRUE(std::equal(bytes.begin(), bytes.end(), kHeader.begin()));
+}
+
+TEST_F(WavFileWriterTest, WritesAndReadsPlanarChannels) {
+  constexpr uint32_t kNumFrames = 5003; // Not a multiple of the vector size.
+  std::array<int16_t, 7> small_buffer{};
+  for (uint16_t num_channels : {1, 2, 3, 4}) {
+    std::vector<std::vector<int16_t>> input(num_channels);
+    std::vector<const int16_t *> planes;
+    for (uint16_t channel = 0; channel < num_channels; channel++) {
+      for (uint32_t i = 0; i < kNumFrames; i++) {
+        input[channel].push_back(
+            static_cast<int16_t>(i * 13 - channel * 1000 - 20000));
+      }
+      planes.push_back(input[channel].data());
+    }
+
+    // The default buffer and one that does not hold a whole number of
+    // frames.
+    for (bool small : {false, true}) {
+      wavgen::Writer writer = small ? wavgen::Writer(small_buffer.data(),
+                                                     small_buffer.size())
+                                    : wavgen::Writer();
+      writer.open(kTestFileName);
+      writer.setNumChannels(num_channels);
+      writer.addFrames(planes.data(), 1000);
+      writer.addFrames(planes.data(), 0);
+      std::vector<const int16_t *> rest;
+      for (const int16_t *plane : planes) {
+        rest.push_back(plane + 1000);
+      }
+      writer.addFrames(rest.data(), kNumFrames - 1000);
+      EXPECT_EQ(writer.getNumSamples(), kNumFrames);
+      writer.done();
+
+      wavgen::Reader reader(kTestFileName);
+      EXPECT_EQ(reader.getFormat().num_channels, num_channels);
+      EXPECT_EQ(reader.getNumSamples(), kNumFrames);
+
+      std::vector<std::vector<int16_t>> output(
+          num_channels, std::vector<int16_t>(kNumFrames));
+      std::vector<int16_t *> output_planes;
+      for (auto &plane : output) {
+        output_planes.push_back(plane.data());
+      }
+      EXPECT_EQ(reader.readPlanar(output_planes.data(), 0, kNumFrames),
+                kNumFrames);
+      EXPECT_EQ(output, input) << num_channels << " " << small;
+
+      // The frames are interleaved on disk.
+      std::vector<float> interleaved(num_channels);
+      reader.read(interleaved.data(), 17, 1,
+                  wavgen::ChannelMode::INTERLEAVED);
+      for (uint16_t channel = 0; channel < num_channels; channel++) {
+        EXPECT_FLOAT_EQ(interleaved[channel], input[channel][17] / 32768.0f);
+      }
+    }
+  }
+}
+
+TEST_F(WavFileWriterTest, ChannelsCanOnlyBeSetBeforeAddingSamples) {
+  wavgen::Writer writer(kTestFileName);
+  EXPECT_THROW(writer.setNumChannels(0), std::runtime_error);
+  writer.clearStatus();
+  writer.addSample(static_cast<int16_t>(1));
+  EXPECT_THROW(writer.setNumChannels(2), std::runtime_error);
+  EXPECT_EQ(writer.getNumChannels(), 1);
+  writer.done();
+}
+
+TEST_F(WavFileWriterTest, FiltersAndOverviewsNeedMonoFiles) {
+  wavgen::BiquadFilter filter({wavgen::BiquadFilter::lowPass(1000.0)});
+  wavgen::Writer writer(kTestFileName);
+  writer.setFilter(&filter);
+  EXPECT_THROW(writer.setNumChannels(2), std::runtime_error);
+  EXPECT_EQ(writer.getNumChannels(), 1);
+  writer.setFilter(nullptr);
+  writer.enableOverview();
+  EXPECT_THROW(writer.setNumChannels(2), std::runtime_error);
+  writer.done();
+  const std::string sidecar = wavgen::Overview::sidecarPath(kTestFileName);
+  ASSERT_TRUE(std::filesystem::remove(sidecar));
+
+  wavgen::Writer stereo(kTestFileName);
+  stereo.setNumChannels(2);
+  EXPECT_THROW(stereo.setFilter(&filter), std::runtime_error);
+  EXPECT_THROW(stereo.enableOverview(), std::runtime_error);
+  EXPECT_EQ(stereo.getStatus(), wavgen::Status::INVALID_ARGUMENT);
+  stereo.clearStatus();
+  stereo.setFilter(nullptr);
+  stereo.done();
+  EXPECT_EQ(stereo.getStatus(), wavgen::Status::OK);
+  EXPECT_FALSE(std::filesystem::exists(sidecar));
+}
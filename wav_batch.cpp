@@ -0,0 +1,55 @@
+/**
+ * @file wav_batch.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Render every job of a manifest file (see wav_batch.hpp).
+ * @date 2023-09-09
+ * @copyright Copyright (c) 2023
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "wav_batch.hpp"
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " <manifest> [threads] [tone_cache_bytes]" << std::endl;
+    return 1;
+  }
+
+  wavgen::BatchOptions options;
+  std::vector<wavgen::BatchJob> jobs;
+  try {
+    if (argc > 2) {
+      options.num_threads = std::stoul(argv[2]);
+    }
+    if (argc > 3) {
+      options.tone_cache_bytes = std::stoull(argv[3]);
+    }
+
+    std::ifstream manifest(argv[1]);
+    if (!manifest.is_open()) {
+      std::cerr << "Failed to open " << argv[1] << std::endl;
+      return 1;
+    }
+    jobs = wavgen::parseBatchManifest(manifest);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto result = wavgen::renderBatch(jobs, options);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  for (const auto &error : result.errors) {
+    std::cerr << error << std::endl;
+  }
+  std::cout << result.jobs_completed << " files rendered, "
+            << result.jobs_failed << " failed in " << elapsed.count() << " s"
+            << std::endl;
+  return result.jobs_failed == 0 ? 0 : 1;
+}
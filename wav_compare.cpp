@@ -0,0 +1,54 @@
+/**
+ * @file wav_compare.cpp
+ * @author Joshua Jerred (https://joshuajer.red)
+ * @brief Compare a 16-bit WAV file with a reference (see wav_tools.hpp).
+ * @date 2023-11-04
+ * @copyright Copyright (c) 2023
+ */
+
+#include <chrono>
+#include <iostream>
+
+#include "wav_tools.hpp"
+
+int main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " <reference> <test> [tolerance] [threads]" << std::endl;
+    return 2;
+  }
+
+  wavgen::CompareOptions options;
+  wavgen::CompareResult result;
+  const auto start = std::chrono::steady_clock::now();
+  try {
+    if (argc > 3) {
+      options.tolerance = std::stoul(argv[3]);
+    }
+    if (argc > 4) {
+      options.num_threads = std::stoul(argv[4]);
+    }
+    result = wavgen::compareFiles(argv[1], argv[2], options);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 2;
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  if (!result.formats_match) {
+    std::cout << "Formats differ" << std::endl;
+  }
+  std::cout << "Samples: " << result.reference_samples << " reference, "
+            << result.test_samples << " test" << std::endl;
+  std::cout << "Mismatches: " << result.num_mismatches;
+  if (result.first_mismatch >= 0) {
+    std::cout << ", first at sample " << result.first_mismatch;
+  }
+  std::cout << std::endl;
+  std::cout << "Max difference: " << result.max_difference << std::endl;
+  std::cout << "SNR: " << result.snr_db << " dB" << std::endl;
+  std::cout << (result.matches() ? "Match" : "Mismatch") << " in "
+            << elapsed.count() << " s" << std::endl;
+  return result.matches() ? 0 : 1;
+}